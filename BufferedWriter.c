@@ -0,0 +1,213 @@
+//-----------------------------------------------------------------------------
+// BufferedWriter.c
+// Implementation file for the BufferedWriter ADT.
+//-----------------------------------------------------------------------------
+
+#include<math.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include "BufferedWriter.h"
+
+// LONGEST_NUMBER is room for any number writeInt() or writeDouble() writes,
+// "%f" of the most negative double being 317 characters.
+#define LONGEST_NUMBER 320
+
+// structs --------------------------------------------------------------------
+
+// private BufferedWriterObj type
+typedef struct BufferedWriterObj
+{
+   FILE* out;
+   char* buffer;
+   size_t capacity;
+   size_t used;
+   bool hasFailed;
+} BufferedWriterObj;
+
+// digitPairs holds "00" to "99" so that integers are written two digits at
+// a time.
+static const char digitPairs[201] =
+   "00010203040506070809101112131415161718192021222324252627282930313233"
+   "34353637383940414243444546474849505152535455565758596061626364656667"
+   "6869707172737475767778798081828384858687888990919293949596979899";
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newBufferedWriter()
+// Returns a writer that appends to out through a buffer of capacity bytes.
+// Precondition: capacity >= 64.
+BufferedWriter newBufferedWriter(FILE* out, size_t capacity)
+{
+   if( out == NULL )
+   {
+      printf("BufferedWriter Error: calling newBufferedWriter() on NULL FILE"
+             " reference.\n");
+      exit(1);
+   }
+   if( capacity < 64 )
+   {
+      printf("BufferedWriter Error: calling newBufferedWriter() with a"
+             " capacity below 64.\n");
+      exit(1);
+   }
+   BufferedWriter W = malloc(sizeof(BufferedWriterObj));
+   W->out = out;
+   W->capacity = (capacity < 2 * LONGEST_NUMBER) ? 2 * LONGEST_NUMBER
+                                                  : capacity;
+   W->buffer = malloc(W->capacity);
+   W->used = 0;
+   W->hasFailed = false;
+   return W;
+}
+
+// freeBufferedWriter()
+// Flushes and frees *pW, setting it to NULL. The FILE is not closed.
+void freeBufferedWriter(BufferedWriter* pW)
+{
+   if( pW != NULL && *pW != NULL )
+   {
+      flushWriter(*pW);
+      free((*pW)->buffer);
+      free(*pW);
+      *pW = NULL;
+   }
+}
+
+// Manipulation procedures ----------------------------------------------------
+
+// reserveRoom()
+// Flushes the buffer if it has less than room bytes free. Private.
+void reserveRoom(BufferedWriter W, size_t room)
+{
+   if( W->capacity - W->used < room )
+   {
+      flushWriter(W);
+   }
+}
+
+// writeChar()
+// Writes the character c.
+void writeChar(BufferedWriter W, char c)
+{
+   reserveRoom(W, 1);
+   W->buffer[W->used++] = c;
+}
+
+// writeText()
+// Writes the characters of the string s.
+void writeText(BufferedWriter W, const char* s)
+{
+   size_t length = strlen(s);
+   while( length > 0 )
+   {
+      size_t chunk;
+      reserveRoom(W, 1);
+      chunk = W->capacity - W->used;
+      if( chunk > length )
+      {
+         chunk = length;
+      }
+      memcpy(W->buffer + W->used, s, chunk);
+      W->used += chunk;
+      s += chunk;
+      length -= chunk;
+   }
+}
+
+// writeDigits()
+// Writes the decimal digits of x at p, which must have room for 20
+// characters, and returns how many were written. Private.
+int writeDigits(char* p, unsigned long long x)
+{
+   char digits[20];
+   int at = 20;
+
+   while( x >= 100 )
+   {
+      int pair = (int)(x % 100) * 2;
+      x /= 100;
+      digits[--at] = digitPairs[pair + 1];
+      digits[--at] = digitPairs[pair];
+   }
+   if( x >= 10 )
+   {
+      digits[--at] = digitPairs[x * 2 + 1];
+      digits[--at] = digitPairs[x * 2];
+   }
+   else
+   {
+      digits[--at] = (char)('0' + x);
+   }
+   memcpy(p, digits + at, 20 - at);
+   return 20 - at;
+}
+
+// writeInt()
+// Writes x as printf("%d") would.
+void writeInt(BufferedWriter W, int x)
+{
+   unsigned long long magnitude = (x < 0) ? -(long long)x : x;
+
+   reserveRoom(W, 21);
+   if( x < 0 )
+   {
+      W->buffer[W->used++] = '-';
+   }
+   W->used += writeDigits(W->buffer + W->used, magnitude);
+}
+
+// writeDouble()
+// Writes x as printf("%f") would.
+void writeDouble(BufferedWriter W, double x)
+{
+   double magnitude = fabs(x);
+   double scaled = magnitude * 1e6;
+   double fraction = scaled - floor(scaled);
+
+   reserveRoom(W, LONGEST_NUMBER);
+
+   // Below 1e7 the product x * 1e6 is off by less than 2^-10 from the exact
+   // value, so rounding it matches printf() unless the fraction is close to
+   // one half. Such numbers, and large or non finite ones, go to snprintf().
+   if( !(magnitude < 1e7) || fabs(fraction - 0.5) < 1e-3 )
+   {
+      W->used += snprintf(W->buffer + W->used, LONGEST_NUMBER, "%f", x);
+      return;
+   }
+   unsigned long long rounded = (unsigned long long)floor(scaled + 0.5);
+   unsigned long long decimals = rounded % 1000000;
+   char* p;
+
+   if( signbit(x) )
+   {
+      W->buffer[W->used++] = '-';
+   }
+   W->used += writeDigits(W->buffer + W->used, rounded / 1000000);
+   p = W->buffer + W->used;
+   p[0] = '.';
+   for( int i = 6; i >= 1; i-- )
+   {
+      p[i] = (char)('0' + decimals % 10);
+      decimals /= 10;
+   }
+   W->used += 7;
+}
+
+// flushWriter()
+// Writes out the buffer. Returns false if any write to the FILE has failed.
+bool flushWriter(BufferedWriter W)
+{
+   if( W == NULL )
+   {
+      printf("BufferedWriter Error: calling flushWriter() on NULL"
+             " BufferedWriter reference.\n");
+      exit(1);
+   }
+   if( W->used > 0 && fwrite(W->buffer, 1, W->used, W->out) != W->used )
+   {
+      W->hasFailed = true;
+   }
+   W->used = 0;
+   return !W->hasFailed;
+}
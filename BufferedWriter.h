@@ -0,0 +1,51 @@
+//-----------------------------------------------------------------------------
+// BufferedWriter.h
+// Header file for the BufferedWriter ADT, which formats numbers into a large
+// buffer and hands it to the FILE in few, large writes.
+//-----------------------------------------------------------------------------
+
+#ifndef _BUFFERED_WRITER_H_INCLUDE_
+#define _BUFFERED_WRITER_H_INCLUDE_
+#include<stdbool.h>
+#include<stdio.h>
+
+// DEFAULT_WRITER_CAPACITY is a buffer size that suits most dumps.
+#define DEFAULT_WRITER_CAPACITY (1 << 20)
+
+// Exported type --------------------------------------------------------------
+typedef struct BufferedWriterObj* BufferedWriter;
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newBufferedWriter()
+// Returns a writer that appends to out through a buffer of capacity bytes.
+// Precondition: capacity >= 64.
+BufferedWriter newBufferedWriter(FILE* out, size_t capacity);
+
+// freeBufferedWriter()
+// Flushes and frees *pW, setting it to NULL. The FILE is not closed.
+void freeBufferedWriter(BufferedWriter* pW);
+
+// Manipulation procedures ----------------------------------------------------
+
+// writeChar()
+// Writes the character c.
+void writeChar(BufferedWriter W, char c);
+
+// writeText()
+// Writes the characters of the string s.
+void writeText(BufferedWriter W, const char* s);
+
+// writeInt()
+// Writes x as printf("%d") would.
+void writeInt(BufferedWriter W, int x);
+
+// writeDouble()
+// Writes x as printf("%f") would.
+void writeDouble(BufferedWriter W, double x);
+
+// flushWriter()
+// Writes out the buffer. Returns false if any write to the FILE has failed.
+bool flushWriter(BufferedWriter W);
+
+#endif
@@ -0,0 +1,342 @@
+//-----------------------------------------------------------------------------
+// CompressedGraph.c
+// Implementation file for the CompressedGraph ADT. Every adjacency list is
+// stored as its length followed by the gaps between consecutive neighbors
+// (the first gap is the first neighbor itself), all written as LEB128
+// varints: seven bits per byte, high bit set on every byte but the last.
+//-----------------------------------------------------------------------------
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include "CompressedGraph.h"
+
+// structs --------------------------------------------------------------------
+
+// private CompressedGraphObj type
+typedef struct CompressedGraphObj
+{
+   int order;
+   long long arcs;
+   size_t* offsets;         // list of u starts at bytes + offsets[u]
+   unsigned char* bytes;
+} CompressedGraphObj;
+
+// Varint functions -----------------------------------------------------------
+
+// varintLength()
+// Returns the number of bytes writeVarint() uses for x. Private.
+int varintLength(unsigned int x)
+{
+   int length = 1;
+   while( x >= 0x80 )
+   {
+      x >>= 7;
+      length++;
+   }
+   return length;
+}
+
+// writeVarint()
+// Writes x at p and returns the number of bytes written. Private.
+int writeVarint(unsigned char* p, unsigned int x)
+{
+   int length = 0;
+   while( x >= 0x80 )
+   {
+      p[length++] = (unsigned char)(x | 0x80);
+      x >>= 7;
+   }
+   p[length++] = (unsigned char)x;
+   return length;
+}
+
+// readVarint()
+// Reads the varint at *pp and advances *pp past it. Private.
+unsigned int readVarint(const unsigned char** pp)
+{
+   const unsigned char* p = *pp;
+   unsigned int x = *p++;
+
+   // Most gaps of a well ordered graph fit in one byte.
+   if( x >= 0x80 )
+   {
+      int shift = 7;
+      x &= 0x7f;
+      do
+      {
+         x |= (unsigned int)(*p & 0x7f) << shift;
+         shift += 7;
+      }
+      while( *p++ >= 0x80 );
+   }
+   *pp = p;
+   return x;
+}
+
+// encodedListLength()
+// Returns the number of bytes the list of count neighbors takes. Private.
+size_t encodedListLength(int* neighbors, int count)
+{
+   size_t length = varintLength(count);
+   int previous = 0;
+   for( int i = 0; i < count; i++ )
+   {
+      length += varintLength(neighbors[i] - previous);
+      previous = neighbors[i];
+   }
+   return length;
+}
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newCompressedGraphFromArrays()
+// Returns a compressed graph of n vertices whose adjacency lists are given
+// as buildWideAdjacencyArrays() lays them out. Every list must be in
+// increasing order.
+CompressedGraph newCompressedGraphFromArrays(int n, long long* offsets,
+                                             int* targets)
+{
+   if( offsets == NULL || targets == NULL )
+   {
+      printf("CompressedGraph Error: calling newCompressedGraphFromArrays()"
+             " with NULL arrays.\n");
+      exit(1);
+   }
+   CompressedGraph C = malloc(sizeof(CompressedGraphObj));
+   C->order = n;
+   C->arcs = offsets[n + 1];
+   C->offsets = malloc((n + 2) * sizeof(size_t));
+
+   // First size every list, then encode them all in parallel.
+   C->offsets[0] = C->offsets[1] = 0;
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int u = 1; u <= n; u++ )
+   {
+      C->offsets[u + 1] = encodedListLength(targets + offsets[u],
+                                            offsets[u + 1] - offsets[u]);
+   }
+   for( int u = 1; u <= n; u++ )
+   {
+      C->offsets[u + 1] += C->offsets[u];
+   }
+   C->bytes = malloc(C->offsets[n + 1] + 1);
+
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int u = 1; u <= n; u++ )
+   {
+      unsigned char* p = C->bytes + C->offsets[u];
+      int previous = 0;
+
+      p += writeVarint(p, offsets[u + 1] - offsets[u]);
+      for( long long e = offsets[u]; e < offsets[u + 1]; e++ )
+      {
+         p += writeVarint(p, targets[e] - previous);
+         previous = targets[e];
+      }
+   }
+   return C;
+}
+
+// newCompressedGraph()
+// Returns a compressed copy of the adjacency lists of G. G is unchanged and
+// can be freed afterwards.
+CompressedGraph newCompressedGraph(Graph G)
+{
+   if( G == NULL )
+   {
+      printf("CompressedGraph Error: calling newCompressedGraph() on NULL"
+             " Graph reference.\n");
+      exit(1);
+   }
+   long long* offsets;
+   int* targets;
+   CompressedGraph C;
+
+   buildWideAdjacencyArrays(G, &offsets, &targets);
+   C = newCompressedGraphFromArrays(getGraphOrder(G), offsets, targets);
+   free(offsets);
+   free(targets);
+   return C;
+}
+
+// freeCompressedGraph()
+// Frees all heap memory associated with *pC and sets *pC to NULL.
+void freeCompressedGraph(CompressedGraph* pC)
+{
+   if( pC != NULL && *pC != NULL )
+   {
+      free((*pC)->offsets);
+      free((*pC)->bytes);
+      free(*pC);
+      *pC = NULL;
+   }
+}
+
+// Access functions -----------------------------------------------------------
+
+// getCompressedOrder()
+// Returns the number of vertices.
+int getCompressedOrder(CompressedGraph C)
+{
+   if( C == NULL )
+   {
+      printf("CompressedGraph Error: calling getCompressedOrder() on NULL"
+             " CompressedGraph reference.\n");
+      exit(1);
+   }
+   return C->order;
+}
+
+// getCompressedArcs()
+// Returns the number of stored adjacency entries (an edge added with
+// addEdge() is stored twice).
+long long getCompressedArcs(CompressedGraph C)
+{
+   if( C == NULL )
+   {
+      printf("CompressedGraph Error: calling getCompressedArcs() on NULL"
+             " CompressedGraph reference.\n");
+      exit(1);
+   }
+   return C->arcs;
+}
+
+// getCompressedDegree()
+// Returns the length of the adjacency list of u.
+// Precondition: 1 <= u <= getCompressedOrder(C).
+int getCompressedDegree(CompressedGraph C, int u)
+{
+   if( C == NULL )
+   {
+      printf("CompressedGraph Error: calling getCompressedDegree() on NULL"
+             " CompressedGraph reference.\n");
+      exit(1);
+   }
+   if( u < 1 || u > C->order )
+   {
+      printf("CompressedGraph Error: calling getCompressedDegree() for an"
+             " out of bounds vertex.\n");
+      exit(1);
+   }
+   const unsigned char* p = C->bytes + C->offsets[u];
+   return readVarint(&p);
+}
+
+// getCompressedBytes()
+// Returns the number of bytes used by the encoded lists and their offsets.
+size_t getCompressedBytes(CompressedGraph C)
+{
+   if( C == NULL )
+   {
+      printf("CompressedGraph Error: calling getCompressedBytes() on NULL"
+             " CompressedGraph reference.\n");
+      exit(1);
+   }
+   return C->offsets[C->order + 1] + (C->order + 2) * sizeof(size_t);
+}
+
+// Neighbor iteration ---------------------------------------------------------
+
+// neighborsMoveFront()
+// Places *pN before the first neighbor of u.
+// Precondition: 1 <= u <= getCompressedOrder(C).
+void neighborsMoveFront(CompressedGraph C, int u, NeighborCursor* pN)
+{
+   if( C == NULL || pN == NULL )
+   {
+      printf("CompressedGraph Error: calling neighborsMoveFront() on NULL"
+             " reference.\n");
+      exit(1);
+   }
+   if( u < 1 || u > C->order )
+   {
+      printf("CompressedGraph Error: calling neighborsMoveFront() for an"
+             " out of bounds vertex.\n");
+      exit(1);
+   }
+   pN->next = C->bytes + C->offsets[u];
+   pN->remaining = readVarint(&pN->next);
+   pN->current = 0;
+}
+
+// neighborsNext()
+// Decodes the next neighbor into *pV and returns 1, or returns 0 once the
+// list is exhausted.
+int neighborsNext(NeighborCursor* pN, int* pV)
+{
+   if( pN->remaining == 0 )
+   {
+      return 0;
+   }
+   pN->current += readVarint(&pN->next);
+   pN->remaining--;
+   *pV = pN->current;
+   return 1;
+}
+
+// decodeNeighbors()
+// Decodes the whole adjacency list of u into out, which must have room for
+// getCompressedDegree(C, u) values, and returns its length.
+int decodeNeighbors(CompressedGraph C, int u, int* out)
+{
+   NeighborCursor N;
+   int count = 0;
+
+   neighborsMoveFront(C, u, &N);
+   while( neighborsNext(&N, &out[count]) )
+   {
+      count++;
+   }
+   return count;
+}
+
+// Algorithms -----------------------------------------------------------------
+
+// compressedBFS()
+// Runs breadth first search from s, decoding adjacency lists as they are
+// reached. Stores in distance[1..n] and parents[1..n] the same values that
+// getDist() and getParent() report after BFS() on the original Graph.
+// Precondition: 1 <= s <= getCompressedOrder(C).
+void compressedBFS(CompressedGraph C, int s, int* distance, int* parents)
+{
+   if( C == NULL || distance == NULL || parents == NULL )
+   {
+      printf("CompressedGraph Error: calling compressedBFS() on NULL"
+             " reference.\n");
+      exit(1);
+   }
+   if( s < 1 || s > C->order )
+   {
+      printf("CompressedGraph Error: calling compressedBFS() with an out of"
+             " bounds source.\n");
+      exit(1);
+   }
+   int* queue = malloc(C->order * sizeof(int));
+   int head = 0, tail = 0;
+   NeighborCursor N;
+   int v;
+
+   for( int i = 1; i <= C->order; i++ )
+   {
+      distance[i] = INF;
+      parents[i] = NIL;
+   }
+   distance[s] = 0;
+   queue[tail++] = s;
+
+   while( head < tail )
+   {
+      int u = queue[head++];
+      for( neighborsMoveFront(C, u, &N); neighborsNext(&N, &v); )
+      {
+         if( distance[v] == INF )
+         {
+            distance[v] = distance[u] + 1;
+            parents[v] = u;
+            queue[tail++] = v;
+         }
+      }
+   }
+   free(queue);
+}
@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+// CompressedGraph.h
+// Header file for the CompressedGraph ADT, a read-only copy of a Graph whose
+// adjacency lists are gap encoded as varints.
+//-----------------------------------------------------------------------------
+
+#ifndef _COMPRESSED_GRAPH_H_INCLUDE_
+#define _COMPRESSED_GRAPH_H_INCLUDE_
+#include<stddef.h>
+#include "Graph.h"
+
+// Exported types -------------------------------------------------------------
+typedef struct CompressedGraphObj* CompressedGraph;
+
+// NeighborCursor
+// Decodes one adjacency list of a CompressedGraph on the fly. It lives on
+// the caller's stack, so any number of threads can walk the same graph.
+typedef struct NeighborCursor
+{
+   const unsigned char* next;
+   int remaining;
+   int current;
+} NeighborCursor;
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newCompressedGraph()
+// Returns a compressed copy of the adjacency lists of G. G is unchanged and
+// can be freed afterwards.
+CompressedGraph newCompressedGraph(Graph G);
+
+// newCompressedGraphFromArrays()
+// Returns a compressed graph of n vertices whose adjacency lists are given
+// as buildWideAdjacencyArrays() lays them out. Every list must be in
+// increasing order.
+CompressedGraph newCompressedGraphFromArrays(int n, long long* offsets,
+                                             int* targets);
+
+// freeCompressedGraph()
+// Frees all heap memory associated with *pC and sets *pC to NULL.
+void freeCompressedGraph(CompressedGraph* pC);
+
+// Access functions -----------------------------------------------------------
+
+// getCompressedOrder()
+// Returns the number of vertices.
+int getCompressedOrder(CompressedGraph C);
+
+// getCompressedArcs()
+// Returns the number of stored adjacency entries (an edge added with
+// addEdge() is stored twice).
+long long getCompressedArcs(CompressedGraph C);
+
+// getCompressedDegree()
+// Returns the length of the adjacency list of u.
+// Precondition: 1 <= u <= getCompressedOrder(C).
+int getCompressedDegree(CompressedGraph C, int u);
+
+// getCompressedBytes()
+// Returns the number of bytes used by the encoded lists and their offsets.
+size_t getCompressedBytes(CompressedGraph C);
+
+// Neighbor iteration ---------------------------------------------------------
+
+// neighborsMoveFront()
+// Places *pN before the first neighbor of u.
+// Precondition: 1 <= u <= getCompressedOrder(C).
+void neighborsMoveFront(CompressedGraph C, int u, NeighborCursor* pN);
+
+// neighborsNext()
+// Decodes the next neighbor into *pV and returns 1, or returns 0 once the
+// list is exhausted.
+int neighborsNext(NeighborCursor* pN, int* pV);
+
+// decodeNeighbors()
+// Decodes the whole adjacency list of u into out, which must have room for
+// getCompressedDegree(C, u) values, and returns its length.
+int decodeNeighbors(CompressedGraph C, int u, int* out);
+
+// Algorithms -----------------------------------------------------------------
+
+// compressedBFS()
+// Runs breadth first search from s, decoding adjacency lists as they are
+// reached. Stores in distance[1..n] and parents[1..n] the same values that
+// getDist() and getParent() report after BFS() on the original Graph.
+// Precondition: 1 <= s <= getCompressedOrder(C).
+void compressedBFS(CompressedGraph C, int s, int* distance, int* parents);
+
+#endif
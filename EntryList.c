@@ -6,13 +6,15 @@
 #include<stdlib.h>
 #include<string.h>
 #include "EntryList.h"
+#include "Matrix.h"
+#include "MemoryUsage.h"
 
 // structs --------------------------------------------------------------------
 
 // private NodeObj type
 typedef struct NodeObj
 {
-   Entry data;
+   EntryObj data;
    struct NodeObj* next;
    struct NodeObj* previous;
 } NodeObj; 
@@ -34,12 +36,14 @@ typedef struct ListObj
 // Constructors-Destructors ---------------------------------------------------
 
 // newNode()
-// Returns reference to new Node object. Initializes next and data fields.
+// Returns reference to new Node object holding a copy of the entry data.
+// Initializes next and data fields.
 // Private.
 Node newNode(Entry data)
 {
    Node N = malloc(sizeof(NodeObj));
-   N->data = data;
+   countAllocation(sizeof(NodeObj));
+   N->data = *data;
    N->next = NULL;
    N->previous = NULL;
    return(N);
@@ -53,6 +57,7 @@ void freeNode(Node* pN)
    if( pN!=NULL && *pN!=NULL )
    {
       free(*pN);
+      countRelease(sizeof(NodeObj));
       *pN = NULL;
    }
 }
@@ -63,6 +68,7 @@ List newList(void)
 {
    List L;
    L = malloc(sizeof(ListObj));
+   countAllocation(sizeof(ListObj));
    L->front = L->back = L->cursor = NULL; 
    L->length = 0;
    L->Index = -1;
@@ -82,6 +88,7 @@ void freeList(List* pL)
    }
    clear(*pL);                                                    
    free(*pL);
+   countRelease(sizeof(ListObj));
    *pL = NULL;
 }
 
@@ -126,7 +133,7 @@ Entry front(List L)
       printf("List Error: calling front() on an empty List.\n");
       exit(1);
    }
-   return(L->front->data);
+   return &(L->front->data);
 }
 
 // back()
@@ -144,7 +151,7 @@ Entry back(List L)
       printf("List Error: calling back() on an empty List.\n");
       exit(1);
    }
-   return(L->back->data);
+   return &(L->back->data);
 }
 
 // get()
@@ -161,7 +168,43 @@ Entry get(List L)
       printf("List Error: calling get() on undefined cursor.\n");
       exit(1);
    }
-   return L->cursor->data; 
+   return &(L->cursor->data);
+}
+
+// getColumn()
+// Returns the column of the cursor entry.
+// Pre: Index() >= 0
+int getColumn(List L)
+{
+   if( L==NULL )
+   {
+      printf("List Error: calling getColumn() on NULL List reference.\n");
+      exit(1);
+   }
+   if( Index(L) < 0 )
+   {
+      printf("List Error: calling getColumn() on undefined cursor.\n");
+      exit(1);
+   }
+   return L->cursor->data.columnNumber;
+}
+
+// getData()
+// Returns the value of the cursor entry.
+// Pre: Index() >= 0
+double getData(List L)
+{
+   if( L==NULL )
+   {
+      printf("List Error: calling getData() on NULL List reference.\n");
+      exit(1);
+   }
+   if( Index(L) < 0 )
+   {
+      printf("List Error: calling getData() on undefined cursor.\n");
+      exit(1);
+   }
+   return L->cursor->data.data;
 }
 
 // areListEquals()
@@ -183,13 +226,85 @@ bool areListsEqual(List A, List B)
    M = B->front;
    while( eq && N!=NULL)
    {
-      eq = areEntriesEqual(N->data, M->data);
+      eq = areEntriesEqual(&(N->data), &(M->data));
       N = N->next;
       M = M->next;
    }
    return eq;
 } 
 
+// listBegin()
+// Returns an iterator under the front element of L, or at the end if L is
+// empty.
+ListIterator listBegin(List L)
+{
+   if( L==NULL )
+   {
+      printf("List Error: calling listBegin() on NULL List reference.\n");
+      exit(1);
+   }
+   ListIterator I = { L->front };
+   return I;
+}
+
+// listAtEnd()
+// Returns true if I has gone past the back of its List.
+bool listAtEnd(ListIterator I)
+{
+   return I.node == NULL;
+}
+
+// iteratorEntry()
+// Returns the entry under I.
+// Pre: !listAtEnd(I)
+Entry iteratorEntry(ListIterator I)
+{
+   return &(I.node->data);
+}
+
+// iteratorColumn()
+// Returns the column of the entry under I.
+// Pre: !listAtEnd(I)
+int iteratorColumn(ListIterator I)
+{
+   return I.node->data.columnNumber;
+}
+
+// iteratorData()
+// Returns the value of the entry under I.
+// Pre: !listAtEnd(I)
+double iteratorData(ListIterator I)
+{
+   return I.node->data.data;
+}
+
+// iteratorNext()
+// Moves *pI to the next element of its List.
+// Pre: !listAtEnd(*pI)
+void iteratorNext(ListIterator* pI)
+{
+   pI->node = pI->node->next;
+}
+
+// listMemoryUsage()
+// Returns the bytes held by L: its nodes, with the entries inside them, and
+// the list struct itself.
+MemoryUsage listMemoryUsage(List L)
+{
+   if( L==NULL )
+   {
+      printf("List Error: calling listMemoryUsage() on NULL List"
+             " reference.\n");
+      exit(1);
+   }
+   MemoryUsage U = newMemoryUsage();
+   U.nodeBytes = L->length * (sizeof(NodeObj) - sizeof(EntryObj));
+   U.entryBytes = L->length * sizeof(EntryObj);
+   U.indexBytes = sizeof(ListObj);
+   U.allocations = L->length + 1;
+   return U;
+}
+
 // Manipulation procedures ----------------------------------------------------
 
 
@@ -290,7 +405,7 @@ void moveNext(List L)
 }
 
 // prepend()
-// Insert new element into this List. If List is non-empty,
+// Insert a copy of the entry data into this List. If List is non-empty,
 // insertion takes place before front element.
 void prepend(List L, Entry data) 
 {
@@ -320,7 +435,7 @@ void prepend(List L, Entry data)
 }
 
 // append()
-// Insert new element into this List. If List is non-empty,
+// Insert a copy of the entry data into this List. If List is non-empty,
 // insertion takes place after back element.
 void append(List L, Entry data)  
 {
@@ -346,7 +461,7 @@ void append(List L, Entry data)
 }
 
 // insertBefore()
-// Insert new element before cursor.
+// Insert a copy of the entry data before cursor.
 // Pre: length()>0, Index() >=0
 void insertBefore(List L, Entry data)
 {
@@ -386,7 +501,7 @@ void insertBefore(List L, Entry data)
 }
 
 // insertAfter()
-// Insert new element after cursor.
+// Insert a copy of the entry data after cursor.
 // Pre: length()>0, Index() >=0
 void insertAfter(List L, Entry data)
 {
@@ -424,6 +539,42 @@ void insertAfter(List L, Entry data)
    (L->length)++;
 }
 
+// appendEntry()
+// Appends the entry (column, data) without allocating an Entry.
+void appendEntry(List L, int column, double data)
+{
+   EntryObj E = { data, column };
+   append(L, &E);
+}
+
+// insertEntryBefore()
+// Inserts the entry (column, data) before the cursor without allocating an
+// Entry.
+// Pre: length()>0, Index() >=0
+void insertEntryBefore(List L, int column, double data)
+{
+   EntryObj E = { data, column };
+   insertBefore(L, &E);
+}
+
+// setCursorData()
+// Changes the value of the cursor entry to x.
+// Pre: Index() >= 0
+void setCursorData(List L, double x)
+{
+   if( L==NULL )
+   {
+      printf("List Error: calling setCursorData() on NULL List reference.\n");
+      exit(1);
+   }
+   if( Index(L) < 0 )
+   {
+      printf("List Error: calling setCursorData() on undefined cursor.\n");
+      exit(1);
+   }
+   L->cursor->data.data = x;
+}
+
 // deleteFront()
 // Deletes the front element. Pre: length() > 0
 void deleteFront(List L) 
@@ -555,6 +706,35 @@ void delete(List L)
    (L->length)--;
 }
 
+// deleteAndMoveNext()
+// Deletes cursor element and moves the cursor to the element that followed
+// it, or makes the cursor undefined if it was the back element.
+// Pre: length()>0, Index() >= 0
+void deleteAndMoveNext(List L)
+{
+   if( L==NULL )
+   {
+      printf("List Error: calling deleteAndMoveNext() on NULL List"
+             " reference.\n");
+      exit(1);
+   }
+   if( Index(L) == -1 )
+   {
+      printf("List Error: calling deleteAndMoveNext() on undefined"
+             " cursor.\n");
+      exit(1);
+   }
+   int index = Index(L);
+   Node next = L->cursor->next;
+
+   delete(L);
+   if( next != NULL )
+   {
+      L->cursor = next;
+      L->Index = index;
+   }
+}
+
 // Other Functions ------------------------------------------------------------
 
 // listToString()
@@ -570,7 +750,7 @@ void listToString(List L, FILE* out)
    }
    for(N = L->front; N != NULL; N = N->next)
    {
-      entryToString(N->data, out);
+      entryToString(&(N->data), out);
       fprintf(out, " ");
    }
 }                                                                           
@@ -592,10 +772,9 @@ List copyList(List L)
 
    while( traverseNode != NULL )
    {
-      append(listCopy, traverseNode->data); 
+      append(listCopy, &(traverseNode->data)); 
       traverseNode = traverseNode->next;
    }
-   freeNode(&traverseNode);
    return listCopy;
 }
 
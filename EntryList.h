@@ -5,12 +5,32 @@
 #ifndef _ENTRYLIST_H_INCLUDE_
 #define _ENTRYLIST_H_INCLUDE_
 #include<stdbool.h>
-#include"Matrix.h"
+#include<stdio.h>
+#include "MemoryUsage.h"
 
 // Exported type --------------------------------------------------------------
 typedef struct ListObj* List;
 typedef struct EntryObj* Entry;
 
+// EntryObj
+// A (column, value) pair of a Matrix row. Nodes hold their EntryObj inline,
+// so the Entry returned by front(), back() or get() points into the List and
+// stays valid until that element is deleted.
+typedef struct EntryObj
+{
+   double data;
+   int columnNumber;
+} EntryObj;
+
+// ListIterator
+// A read position in a List that leaves its cursor alone, so that any
+// number of them can walk the same List at once, on any thread, as long as
+// nobody changes the List meanwhile. Its field is private.
+typedef struct ListIterator
+{
+   struct NodeObj* node;
+} ListIterator;
+
 // Constructors-Destructors ---------------------------------------------------
 
 // newList()
@@ -43,10 +63,54 @@ Entry back(List L);
 // Returns the data of the cursor node.
 Entry get(List L);
 
+// getColumn()
+// Returns the column of the cursor entry.
+// Pre: Index() >= 0
+int getColumn(List L);
+
+// getData()
+// Returns the value of the cursor entry.
+// Pre: Index() >= 0
+double getData(List L);
+
 // areListsEquals()
 // returns true (1) if A is identical to B, false (0) otherwise.
 bool areListsEqual(List A, List B);
 
+// listBegin()
+// Returns an iterator under the front element of L, or at the end if L is
+// empty.
+ListIterator listBegin(List L);
+
+// listAtEnd()
+// Returns true if I has gone past the back of its List.
+bool listAtEnd(ListIterator I);
+
+// iteratorEntry()
+// Returns the entry under I.
+// Pre: !listAtEnd(I)
+Entry iteratorEntry(ListIterator I);
+
+// iteratorColumn()
+// Returns the column of the entry under I.
+// Pre: !listAtEnd(I)
+int iteratorColumn(ListIterator I);
+
+// iteratorData()
+// Returns the value of the entry under I.
+// Pre: !listAtEnd(I)
+double iteratorData(ListIterator I);
+
+// iteratorNext()
+// Moves *pI to the next element of its List.
+// Pre: !listAtEnd(*pI)
+void iteratorNext(ListIterator* pI);
+
+// listMemoryUsage()
+// Returns the bytes held by L: its nodes, with the entries inside them, and
+// the list struct itself.
+MemoryUsage listMemoryUsage(List L);
+
 // Manipulation procedures ----------------------------------------------------
 
 // clear()
@@ -77,25 +141,40 @@ void movePrev(List L);
 void moveNext(List L);
 
 // prepend()
-// insert new element into this List. If List is non-empty,
+// insert a copy of the entry data into this List. If List is non-empty,
 // insertion takes place before front element.
 void prepend(List L, Entry data);
 
 // append()
-// insert new element into this List. If List is non-empty,
+// insert a copy of the entry data into this List. If List is non-empty,
 // insertion takes place after back element.
 void append(List L, Entry data);
 
 // insertBefore()
-// insert new element before cursor.
+// insert a copy of the entry data before cursor.
 // Pre: length()>0, Index() >=0
 void insertBefore(List L, Entry data);
 
 // insertAfter()
-// insert new element after cursor.
+// insert a copy of the entry data after cursor.
 // Pre: length()>0, Index() >=0
 void insertAfter(List L, Entry data);
 
+// appendEntry()
+// Appends the entry (column, data) without allocating an Entry.
+void appendEntry(List L, int column, double data);
+
+// insertEntryBefore()
+// Inserts the entry (column, data) before the cursor without allocating an
+// Entry.
+// Pre: length()>0, Index() >=0
+void insertEntryBefore(List L, int column, double data);
+
+// setCursorData()
+// Changes the value of the cursor entry to x.
+// Pre: Index() >= 0
+void setCursorData(List L, double x);
+
 // deleteFront()
 // Deletes the front element. Pre: length() > 0
 void deleteFront(List L);
@@ -109,6 +188,12 @@ void deleteBack(List L);
 // Pre: length()>0, Index() >= 0
 void delete(List L);
 
+// deleteAndMoveNext()
+// Deletes cursor element and moves the cursor to the element that followed
+// it, or makes the cursor undefined if it was the back element.
+// Pre: length()>0, Index() >= 0
+void deleteAndMoveNext(List L);
+
 // Other Functions ------------------------------------------------------------
 
 // listToString()
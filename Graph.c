@@ -16,11 +16,18 @@ entry of my todo queue.
 // Fernando Zegada
 // Implementation of the Graph ADT in C.
 
+#include<math.h>
+#include<limits.h>
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
 #include <stdbool.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "BufferedWriter.h"
 #include "Graph.h"
+#include "MemoryUsage.h"
 //#define NIL 0
 //#define INF -2 // -2 to not get confused with the undefined index of a list.
 
@@ -32,7 +39,7 @@ typedef struct GraphObj
    int size;
    int source;
 
-   List* neighbors;
+   IntList* neighbors;
    bool* beenVisited;
    int* parents;
    int* distance;
@@ -54,10 +61,18 @@ Graph newGraph(int n)
    G->beenVisited = (bool *)malloc( (n + 1) * sizeof(bool) ); 
    G->parents = (int *)malloc( (n + 1) * sizeof(int) );
    G->distance = (int *)malloc( (n + 1) * sizeof(int) );
+   countAllocation(sizeof(GraphObj));
+   countAllocation((n + 1) * sizeof(IntList));
+   countAllocation((n + 1) * sizeof(bool));
+   countAllocation((n + 1) * sizeof(int));
+   countAllocation((n + 1) * sizeof(int));
 
+   // Adjacency lists are only ever walked in order, which unrolled lists
+   // do with a fraction of the memory traffic, and sorted ones take a new
+   // neighbor in O(log d) time even at hubs of millions of neighbors.
    for( int i = 0; i <= n; i++ )
    {
-      G->neighbors[i] = newIntList();
+      G->neighbors[i] = newSortedIntList();
       G->beenVisited[i] = false;
       G->parents[i] = NIL;
       G->distance[i] = INF;
@@ -85,6 +100,11 @@ void freeGraph(Graph* pG)
    free( (*pG)->parents );
    free( (*pG)->distance );
    free( (*pG)->neighbors );
+   countRelease((n + 1) * sizeof(bool));
+   countRelease((n + 1) * sizeof(int));
+   countRelease((n + 1) * sizeof(int));
+   countRelease((n + 1) * sizeof(IntList));
+   countRelease(sizeof(GraphObj));
 
    (*pG)->size = 0;
    free(*pG);
@@ -117,6 +137,30 @@ int getGraphSize(Graph G)
    return G->size;
 }
 
+// graphMemoryUsage()
+// Returns the bytes held by G: the adjacency lists and their nodes, the
+// array of lists and the graphObj itself, and the BFS() state arrays.
+MemoryUsage graphMemoryUsage(Graph G)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling graphMemoryUsage() on NULL Graph"
+             " reference.\n");
+      exit(1);
+   }
+   MemoryUsage U = newMemoryUsage();
+   int n = G->order;
+
+   U.indexBytes = sizeof(GraphObj) + (n + 1) * sizeof(IntList);
+   U.traversalBytes = (n + 1) * (sizeof(bool) + 2 * sizeof(int));
+   U.allocations = 5;
+   for( int i = 0; i <= n; i++ )
+   {
+      addMemoryUsage(&U, IntListMemoryUsage(G->neighbors[i]));
+   }
+   return U;
+}
+
 // getSource()
 // Returns the vertex that was most recently the source of BFS() or NIL
 // if BFS() has never been called.
@@ -268,7 +312,131 @@ void addArc(Graph G, int u, int v)
    (G->size)++;
 }
 
-// BFS()  // NOT WORKING IN THIS IMPLEMENTATION!
+// compareVertices()
+// qsort() comparison function for arrays of vertices. Private.
+int compareVertices(const void* a, const void* b)
+{
+   int u = *(const int*)a;
+   int v = *(const int*)b;
+   return (u > v) - (u < v);
+}
+
+// addEdges()
+// Inserts count edges at once, the i-th joining sources[i] and targets[i],
+// or arcs from sources[i] to targets[i] if isDirected is true. Leaves G as
+// the same sequence of addEdge() or addArc() calls would, but merges a
+// sorted batch into every adjacency list in a single pass, in parallel.
+// Precondition: all vertices must be between 1 and the order of the graph,
+// the batch holds at most INT_MAX arcs and the graph INT_MAX edges.
+void addEdges(Graph G, int* sources, int* targets, int count,
+              bool isDirected)
+{
+   if( G==NULL || sources==NULL || targets==NULL )
+   {
+      printf("Graph Error: calling addEdges() on NULL Graph or edge array"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   long long arcs = isDirected ? count : 2LL * count;
+   int* start;
+   int* next;
+   int* batch;
+
+   if( arcs > INT_MAX || (long long)G->size + count > INT_MAX )
+   {
+      printf("Graph Error: calling addEdges() with more than INT_MAX arcs"
+             " in the batch or edges in the graph.\n");
+      exit(1);
+   }
+   start = calloc(n + 2, sizeof(int));
+   next = malloc((n + 2) * sizeof(int));
+   batch = malloc((arcs + 1) * sizeof(int));
+
+   for( int i = 0; i < count; i++ )
+   {
+      if( sources[i] <= 0 || n < sources[i] || targets[i] <= 0
+          || n < targets[i] )
+      {
+         printf("Graph Error: calling addEdges() for (an) out of bounds\n"
+                "vertex (or vertices).\n");
+         exit(1);
+      }
+      start[sources[i] + 1]++;
+      if( !isDirected )
+      {
+         start[targets[i] + 1]++;
+      }
+   }
+   for( int u = 1; u <= n; u++ )
+   {
+      start[u + 1] += start[u];
+   }
+   memcpy(next, start, (n + 2) * sizeof(int));
+   for( int i = 0; i < count; i++ )
+   {
+      batch[next[sources[i]]++] = targets[i];
+      if( !isDirected )
+      {
+         batch[next[targets[i]]++] = sources[i];
+      }
+   }
+
+   // Every list is only touched by the thread merging into it.
+   #pragma omp parallel for schedule(dynamic, 64)
+   for( int u = 1; u <= n; u++ )
+   {
+      IntList L = G->neighbors[u];
+      int* added = batch + start[u];
+      int addedCount = start[u + 1] - start[u];
+
+      qsort(added, addedCount, sizeof(int), compareVertices);
+
+      // A few edges into a long list are cheaper to place one at a time.
+      if( (long long)addedCount * 64 < IntListLength(L) )
+      {
+         for( int k = 0; k < addedCount; k++ )
+         {
+            IntListInsertInOrder(&L, added[k]);
+         }
+         continue;
+      }
+      IntListMoveFront(L);
+      for( int k = 0; k < addedCount; k++ )
+      {
+         while( IntListIndex(L) != -1 && IntListGet(L) <= added[k] )
+         {
+            IntListMoveNext(L);
+         }
+         if( IntListIndex(L) == -1 )
+         {
+            IntListAppend(L, added[k]);
+         }
+         else
+         {
+            IntListInsertBefore(L, added[k]);
+         }
+      }
+   }
+   G->size += count;
+
+   free(start);
+   free(next);
+   free(batch);
+}
+
+// buildGraph()
+// Returns a graph with n vertices holding the count edges (or arcs) given
+// as in addEdges().
+Graph buildGraph(int n, int* sources, int* targets, int count,
+                 bool isDirected)
+{
+   Graph G = newGraph(n);
+   addEdges(G, sources, targets, count, isDirected);
+   return G;
+}
+
+// BFS()
 // Implements the breadth first search algorithm.
 // precondition source is not out of bounds.
 void BFS(Graph G, int s)
@@ -283,8 +451,7 @@ void BFS(Graph G, int s)
       printf("Graph Error: calling BFS() with an out of bounds source.\n");
       exit(1);
    }
-   IntList Q = newList();
-   IntList * workingAdjList;
+   IntList Q = newIntList();
    int v = 0, u = 0;
 
    G->source = s;
@@ -300,18 +467,15 @@ void BFS(Graph G, int s)
 
    IntListAppend(Q, s);
 
-   while( length(Q) != 0 )
+   while( IntListLength(Q) != 0 )
    {
-      u = front(Q);
+      u = IntListFront(Q);
       IntListDeleteFront(Q);
    
-      workingAdjList = &(G->neighbors[u]);
-      for
-      ( IntListMoveFront(*workingAdjList);
-        IntListIndex(*workingAdjList) != -1;
-        IntListMoveNext(*workingAdjList)
-      ){
-         v = IntListGet(*workingAdjList);
+      for( IntListIterator I = IntListBegin(G->neighbors[u]);
+           !IntListAtEnd(I); IntListIteratorNext(&I) )
+      {
+         v = IntListIteratorGet(I);
          if( !(G->beenVisited[v]) )
          {
             G->beenVisited[v] = true;
@@ -322,25 +486,112 @@ void BFS(Graph G, int s)
       }
    }
    freeIntList(&Q);
-}  // PROBABLY NOT WORKING IN THIS IMPLEMENTATION!
+}
 
 // Other Functions ------------------------------------------------------------
 
+// writeGraphRows()
+// Writes the graphToString() lines of vertices first to last to W. Private.
+void writeGraphRows(BufferedWriter W, Graph G, int first, int last)
+{
+   for( int i = first; i <= last; i++ )
+   {
+      IntList L = G->neighbors[i];
+
+      writeInt(W, i);
+      writeText(W, ": ");
+      for( IntListIterator I = IntListBegin(L); !IntListAtEnd(I);
+           IntListIteratorNext(&I) )
+      {
+         writeInt(W, IntListIteratorGet(I));
+         writeChar(W, ' ');
+      }
+      writeChar(W, '\n');
+   }
+}
+
 // graphToString()
-// writes the a representation of the graph to an input file
-void graphToString(FILE* out, Graph G) // change to graphToString().
+// Writes the adjacency list representation of the graph to out, one
+// "u: neighbors" line per vertex, through a large buffer.
+void graphToString(FILE* out, Graph G)
 {
    if( G==NULL )
    {
-      printf("Graph Error: calling printGraph() on NULL Graph reference.\n");
+      printf("Graph Error: calling graphToString() on NULL Graph reference.\n");
       exit(1);
    }
-   for(int i = 1; i <= getGraphOrder(G); i++ )
-   { 
-      fprintf( out, "%d: ",i); 
-      intListToString(out,  G->neighbors[i]);
-      fprintf(out, "\n"); 
+   BufferedWriter W = newBufferedWriter(out, DEFAULT_WRITER_CAPACITY);
+   writeGraphRows(W, G, 1, getGraphOrder(G));
+   freeBufferedWriter(&W);
+}
+
+// writeGraphSegments()
+// Writes the lines of graphToString() to segmentCount files named
+// pathPrefix.0, pathPrefix.1, ... in parallel, splitting the vertices into
+// ranges of about the same output size. Concatenated in order, the files
+// hold exactly what graphToString() writes. Returns false if a file could
+// not be written.
+bool writeGraphSegments(Graph G, const char* pathPrefix, int segmentCount)
+{
+   if( G==NULL || pathPrefix==NULL )
+   {
+      printf("Graph Error: calling writeGraphSegments() on NULL Graph or"
+             " path reference.\n");
+      exit(1);
    }
+   if( segmentCount < 1 )
+   {
+      printf("Graph Error: calling writeGraphSegments() with fewer than one"
+             " segment.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int* firstRow = malloc((segmentCount + 1) * sizeof(int));
+   long long total = 0, written = 0;
+   bool isWritten = true;
+
+   // A line costs about one unit per neighbor plus one for the vertex.
+   for( int i = 1; i <= n; i++ )
+   {
+      total += IntListLength(G->neighbors[i]) + 1;
+   }
+   firstRow[0] = 1;
+   for( int i = 1, k = 1; k < segmentCount; k++ )
+   {
+      while( i <= n && written < total * k / segmentCount )
+      {
+         written += IntListLength(G->neighbors[i++]) + 1;
+      }
+      firstRow[k] = i;
+   }
+   firstRow[segmentCount] = n + 1;
+
+   #pragma omp parallel for schedule(dynamic, 1) reduction(&&:isWritten)
+   for( int k = 0; k < segmentCount; k++ )
+   {
+      size_t length = strlen(pathPrefix) + 16;
+      char* path = malloc(length);
+      FILE* out;
+
+      snprintf(path, length, "%s.%d", pathPrefix, k);
+      out = fopen(path, "w");
+      if( out == NULL )
+      {
+         isWritten = false;
+      }
+      else
+      {
+         BufferedWriter W = newBufferedWriter(out, DEFAULT_WRITER_CAPACITY);
+         writeGraphRows(W, G, firstRow[k], firstRow[k + 1] - 1);
+         isWritten = flushWriter(W) && isWritten;
+         freeBufferedWriter(&W);
+         isWritten = (fclose(out) == 0) && isWritten;
+      }
+      free(path);
+   }
+
+   free(firstRow);
+   return isWritten;
 }
 
 // Shortest path algorithms and helper functions ------------------------------ 
@@ -357,11 +608,10 @@ void djikstrasAlgorithm(Graph G, Matrix weights, int source)
    {
       x = heapExtractMin(heap);
 
-      for( IntListMoveFront(G->neighbors[x]);
-           IntListIndex(G->neighbors[x]) != -1;
-           IntListMoveNext(G->neighbors[x]) )
+      for( IntListIterator I = IntListBegin(G->neighbors[x]);
+           !IntListAtEnd(I); IntListIteratorNext(&I) )
       {
-         y = IntListGet(G->neighbors[x]);
+         y = IntListIteratorGet(I);
          relax(heap, G, weights, x, y);
       }
    }
@@ -395,3 +645,1032 @@ void relax(Heap H, Graph G, Matrix weights, int vertexX, int vertexY)
       heapDecreaseKey(H, vertexY, newDistance);
    }
 }
+
+
+// Directed acyclic graph algorithms ------------------------------------------
+
+// kahnLevels()
+// Orders the n vertices stored in offsets and targets with Kahn's algorithm.
+// The k-th frontier ends up in order[levelStart[k]] up to but not including
+// order[levelStart[k + 1]], sorted increasingly, and *pLevels is the number
+// of frontiers. Every frontier is processed in parallel. Returns the number
+// of vertices placed, which is less than n only if the arcs have a cycle.
+// Private.
+int kahnLevels(int n, int* offsets, int* targets, int* order,
+               int* levelStart, int* pLevels)
+{
+   int* inDegree = calloc(n + 1, sizeof(int));
+   int head = 0, tail = 0, levels = 0;
+
+   for( int e = 0; e < offsets[n + 1]; e++ )
+   {
+      inDegree[targets[e]]++;
+   }
+   for( int v = 1; v <= n; v++ )
+   {
+      if( inDegree[v] == 0 )
+      {
+         order[tail++] = v;
+      }
+   }
+   while( head < tail )
+   {
+      int frontierEnd = tail;
+      levelStart[levels++] = head;
+
+      #pragma omp parallel for schedule(dynamic, 64)
+      for( int i = head; i < frontierEnd; i++ )
+      {
+         int u = order[i];
+         for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+         {
+            int v = targets[e];
+            int remaining, slot;
+
+            #pragma omp atomic capture
+            remaining = --inDegree[v];
+
+            if( remaining == 0 )
+            {
+               #pragma omp atomic capture
+               slot = tail++;
+
+               order[slot] = v;
+            }
+         }
+      }
+      // Threads fill the next frontier in any order, sort it so that the
+      // result does not depend on the schedule.
+      qsort(order + frontierEnd, tail - frontierEnd, sizeof(int),
+            compareVertices);
+      head = frontierEnd;
+   }
+   levelStart[levels] = tail;
+   *pLevels = levels;
+
+   free(inDegree);
+   return tail;
+}
+
+// appendCycle()
+// Appends to L a directed cycle made of vertices that kahnLevels() could not
+// place. Every such vertex has an unplaced predecessor, so walking backwards
+// through unplaced predecessors must eventually repeat a vertex. Private.
+void appendCycle(IntList L, int n, int* offsets, int* targets,
+                 int* order, int placed)
+{
+   int *reverseOffsets, *sources;
+   bool* isPlaced = calloc(n + 1, sizeof(bool));
+   int* step = calloc(n + 1, sizeof(int));
+   int* walk = malloc(n * sizeof(int));
+   int walkLength = 0, v = 0;
+
+   buildReverseArrays(n, offsets, targets, NULL,
+                      &reverseOffsets, &sources, NULL);
+   for( int i = 0; i < placed; i++ )
+   {
+      isPlaced[order[i]] = true;
+   }
+   for( v = 1; isPlaced[v]; v++ );
+
+   while( step[v] == 0 )
+   {
+      walk[walkLength++] = v;
+      step[v] = walkLength;
+      for( int e = reverseOffsets[v]; e < reverseOffsets[v + 1]; e++ )
+      {
+         if( !isPlaced[sources[e]] )
+         {
+            v = sources[e];
+            break;
+         }
+      }
+   }
+   // The walk followed arcs backwards, append the cycle reversed.
+   for( int i = walkLength - 1; i >= step[v] - 1; i-- )
+   {
+      IntListAppend(L, walk[i]);
+   }
+
+   free(reverseOffsets);
+   free(sources);
+   free(isPlaced);
+   free(step);
+   free(walk);
+}
+
+// topologicalSort()
+// Runs Kahn's algorithm on the arcs of G, processing each frontier of
+// in-degree zero vertices in parallel. If G is acyclic, appends its vertices
+// to L in topological order and returns true. Otherwise appends to L the
+// vertices v1 v2 ... vk of one directed cycle (vk has an arc to v1) and
+// returns false.
+bool topologicalSort(IntList L, Graph G)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling topologicalSort() on NULL Graph"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int *offsets, *targets;
+   int* order = malloc(n * sizeof(int));
+   int* levelStart = malloc((n + 1) * sizeof(int));
+   int levels = 0, placed = 0;
+
+   buildAdjacencyArrays(G, &offsets, &targets);
+   placed = kahnLevels(n, offsets, targets, order, levelStart, &levels);
+
+   if( placed == n )
+   {
+      for( int i = 0; i < n; i++ )
+      {
+         IntListAppend(L, order[i]);
+      }
+   }
+   else
+   {
+      appendCycle(L, n, offsets, targets, order, placed);
+   }
+
+   free(offsets);
+   free(targets);
+   free(order);
+   free(levelStart);
+   return placed == n;
+}
+
+// criticalPath()
+// Appends to L the vertices of a longest path in the DAG G and returns its
+// length. The weight of the arc u->v is getMatrixEntryData(weights, u, v),
+// the same lookup relax() uses; every arc weighs 1 if weights is NULL.
+// Precondition: G has no directed cycles.
+double criticalPath(IntList L, Graph G, Matrix weights)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling criticalPath() on NULL Graph reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int *offsets, *targets, *reverseOffsets, *sources;
+   double *arcWeights, *sourceWeights;
+   int* order = malloc(n * sizeof(int));
+   int* levelStart = malloc((n + 1) * sizeof(int));
+   double* longest = malloc((n + 1) * sizeof(double));
+   int* predecessor = malloc((n + 1) * sizeof(int));
+   int levels = 0, last = 1;
+
+   buildAdjacencyArrays(G, &offsets, &targets);
+   if( kahnLevels(n, offsets, targets, order, levelStart, &levels) != n )
+   {
+      printf("Graph Error: calling criticalPath() on a graph with a"
+             " directed cycle.\n");
+      exit(1);
+   }
+
+   // The weights are looked up once, in one batch, before the parallel
+   // part.
+   arcWeights = malloc((offsets[n + 1] + 1) * sizeof(double));
+   if( weights == NULL )
+   {
+      for( int e = 0; e < offsets[n + 1]; e++ )
+      {
+         arcWeights[e] = 1.0;
+      }
+   }
+   else
+   {
+      int* arcSources = malloc((offsets[n + 1] + 1) * sizeof(int));
+      for( int u = 1; u <= n; u++ )
+      {
+         for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+         {
+            arcSources[e] = u;
+         }
+      }
+      getEntries(weights, targets, arcSources, arcWeights, offsets[n + 1]);
+      free(arcSources);
+   }
+   buildReverseArrays(n, offsets, targets, arcWeights,
+                      &reverseOffsets, &sources, &sourceWeights);
+
+   // Every vertex of a frontier only depends on earlier frontiers, so each
+   // frontier pulls from its predecessors in parallel.
+   for( int k = 0; k < levels; k++ )
+   {
+      #pragma omp parallel for schedule(dynamic, 64)
+      for( int i = levelStart[k]; i < levelStart[k + 1]; i++ )
+      {
+         int v = order[i];
+         longest[v] = 0.0;
+         predecessor[v] = NIL;
+         for( int e = reverseOffsets[v]; e < reverseOffsets[v + 1]; e++ )
+         {
+            int u = sources[e];
+            if( predecessor[v] == NIL
+                || longest[u] + sourceWeights[e] > longest[v] )
+            {
+               longest[v] = longest[u] + sourceWeights[e];
+               predecessor[v] = u;
+            }
+         }
+      }
+   }
+   for( int v = 2; v <= n; v++ )
+   {
+      if( longest[v] > longest[last] )
+      {
+         last = v;
+      }
+   }
+
+   double pathLength = longest[last];
+   IntListAppend(L, last);
+   IntListMoveBack(L);
+   for( int v = predecessor[last]; v != NIL; v = predecessor[v] )
+   {
+      IntListInsertBefore(L, v);
+      IntListMovePrev(L);
+   }
+
+   free(offsets);
+   free(targets);
+   free(reverseOffsets);
+   free(sources);
+   free(arcWeights);
+   free(sourceWeights);
+   free(order);
+   free(levelStart);
+   free(longest);
+   free(predecessor);
+   return pathLength;
+}
+
+// Ranking algorithms ---------------------------------------------------------
+
+// pageRank()
+// Stores in ranks[1..n] the PageRank of every vertex of G with the given
+// damping factor. Vertices without out-going arcs spread their rank evenly
+// over all vertices. Stops once an iteration changes the ranks by less than
+// tolerance (in the 1-norm) or after maxIterations, and returns the number
+// of iterations.
+int pageRank(Graph G, double damping, double tolerance, int maxIterations,
+             double* ranks)
+{
+   if( G==NULL || ranks==NULL )
+   {
+      printf("Graph Error: calling pageRank() on NULL Graph or ranks"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int *offsets, *targets, *sources;
+   double* outShare;
+   double* next = malloc((n + 1) * sizeof(double));
+   int iterations = 0;
+   Matrix transition;
+
+   // Row v of the column stochastic transition matrix holds 1/outdegree(u)
+   // for every arc u->v, so the arcs give its triples reversed.
+   buildAdjacencyArrays(G, &offsets, &targets);
+   sources = malloc((offsets[n + 1] + 1) * sizeof(int));
+   outShare = malloc((offsets[n + 1] + 1) * sizeof(double));
+   for( int u = 1; u <= n; u++ )
+   {
+      for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+      {
+         sources[e] = u;
+         outShare[e] = 1.0 / (offsets[u + 1] - offsets[u]);
+      }
+   }
+   transition = buildCompressedMatrix(n, targets, sources, outShare,
+                                      offsets[n + 1]);
+   free(targets);
+   free(sources);
+   free(outShare);
+
+   for( int v = 1; v <= n; v++ )
+   {
+      ranks[v] = 1.0 / n;
+   }
+   while( iterations < maxIterations )
+   {
+      double dangling = 0.0, change = 0.0, base;
+
+      #pragma omp parallel for reduction(+:dangling)
+      for( int u = 1; u <= n; u++ )
+      {
+         if( offsets[u] == offsets[u + 1] )
+         {
+            dangling += ranks[u];
+         }
+      }
+      spmv(transition, ranks, next);
+      iterations++;
+
+      base = (1.0 - damping + damping * dangling) / n;
+      #pragma omp parallel for reduction(+:change)
+      for( int v = 1; v <= n; v++ )
+      {
+         next[v] = base + damping * next[v];
+         change += fabs(next[v] - ranks[v]);
+      }
+      memcpy(ranks + 1, next + 1, n * sizeof(double));
+      if( change < tolerance )
+      {
+         break;
+      }
+   }
+
+   free(offsets);
+   freeMatrix(&transition);
+   free(next);
+   return iterations;
+}
+
+// Triangle algorithms --------------------------------------------------------
+
+// GALLOP_RATIO is how many times longer one list must be than the other
+// before intersectLists() switches from merging to galloping.
+#define GALLOP_RATIO 32
+
+// recordTriangle()
+// Adds one triangle to vertex w if per-vertex counts are being kept. Private.
+void recordTriangle(long long* triangles, int w)
+{
+   if( triangles != NULL )
+   {
+      #pragma omp atomic
+      triangles[w]++;
+   }
+}
+
+// intersectMerge()
+// Counts the common elements of the strictly increasing arrays a and b by
+// merging them, four by four with SSE2 when available. Every common element
+// is passed to recordTriangle(). Private.
+int intersectMerge(int* a, int na, int* b, int nb, long long* triangles)
+{
+   int i = 0, j = 0, count = 0;
+
+#ifdef __SSE2__
+   // Compare each block of four from a against all four rotations of the
+   // block from b, then advance whichever block ends with the smaller value.
+   while( i + 4 <= na && j + 4 <= nb )
+   {
+      __m128i blockA = _mm_loadu_si128((const __m128i*)(a + i));
+      __m128i blockB = _mm_loadu_si128((const __m128i*)(b + j));
+      __m128i equal = _mm_or_si128(
+         _mm_or_si128(
+            _mm_cmpeq_epi32(blockA, blockB),
+            _mm_cmpeq_epi32(blockA,
+               _mm_shuffle_epi32(blockB, _MM_SHUFFLE(0, 3, 2, 1)))),
+         _mm_or_si128(
+            _mm_cmpeq_epi32(blockA,
+               _mm_shuffle_epi32(blockB, _MM_SHUFFLE(1, 0, 3, 2))),
+            _mm_cmpeq_epi32(blockA,
+               _mm_shuffle_epi32(blockB, _MM_SHUFFLE(2, 1, 0, 3)))));
+      int mask = _mm_movemask_ps(_mm_castsi128_ps(equal));
+      int lastA = a[i + 3], lastB = b[j + 3];
+
+      while( mask != 0 )
+      {
+         recordTriangle(triangles, a[i + __builtin_ctz(mask)]);
+         count++;
+         mask &= mask - 1;
+      }
+      if( lastA <= lastB )
+      {
+         i += 4;
+      }
+      if( lastB <= lastA )
+      {
+         j += 4;
+      }
+   }
+#endif
+   while( i < na && j < nb )
+   {
+      if( a[i] == b[j] )
+      {
+         recordTriangle(triangles, a[i]);
+         count++;
+         i++;
+         j++;
+      }
+      else if( a[i] < b[j] )
+      {
+         i++;
+      }
+      else
+      {
+         j++;
+      }
+   }
+   return count;
+}
+
+// intersectGallop()
+// Counts the common elements of the strictly increasing arrays a and b,
+// where b is much longer, by searching b for every element of a with an
+// exponential search followed by a binary search. Every common element is
+// passed to recordTriangle(). Private.
+int intersectGallop(int* a, int na, int* b, int nb, long long* triangles)
+{
+   int low = 0, count = 0;
+
+   for( int i = 0; i < na && low < nb; i++ )
+   {
+      int step = 1, high;
+
+      // Find high such that b[high] >= a[i], then binary search below it.
+      while( low + step < nb && b[low + step] < a[i] )
+      {
+         step *= 2;
+      }
+      high = (low + step < nb) ? low + step : nb - 1;
+      low += step / 2;
+      while( low < high )
+      {
+         int middle = low + (high - low) / 2;
+         if( b[middle] < a[i] )
+         {
+            low = middle + 1;
+         }
+         else
+         {
+            high = middle;
+         }
+      }
+      if( b[low] == a[i] )
+      {
+         recordTriangle(triangles, a[i]);
+         count++;
+         low++;
+      }
+   }
+   return count;
+}
+
+// intersectLists()
+// Counts the common elements of two strictly increasing arrays, merging
+// lists of similar length and galloping through skewed ones. Private.
+int intersectLists(int* a, int na, int* b, int nb, long long* triangles)
+{
+   if( (long long)na * GALLOP_RATIO < nb )
+   {
+      return intersectGallop(a, na, b, nb, triangles);
+   }
+   if( (long long)nb * GALLOP_RATIO < na )
+   {
+      return intersectGallop(b, nb, a, na, triangles);
+   }
+   return intersectMerge(a, na, b, nb, triangles);
+}
+
+// triangleCensus()
+// Counts the triangles of G and, when the arrays are not NULL, the
+// triangles through every vertex and the number of distinct neighbors of
+// every vertex. Each edge is oriented from the endpoint of lower degree to
+// the one of higher degree (ties broken by label), so every triangle is found
+// exactly once, from its lowest ranked vertex. Private.
+long long triangleCensus(Graph G, long long* triangles, int* degree)
+{
+   int n = getGraphOrder(G);
+   int *offsets, *targets;
+   int* outOffsets = malloc((n + 2) * sizeof(int));
+   int* outTargets;
+   int* distinct = (degree != NULL) ? degree : malloc((n + 1) * sizeof(int));
+   long long total = 0;
+
+   buildAdjacencyArrays(G, &offsets, &targets);
+   for( int u = 1; u <= n; u++ )
+   {
+      distinct[u] = 0;
+      for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+      {
+         if( targets[e] != u
+             && (e == offsets[u] || targets[e - 1] != targets[e]) )
+         {
+            distinct[u]++;
+         }
+      }
+   }
+
+   // Keep only the neighbors that rank above u. Their order stays increasing.
+   outOffsets[0] = outOffsets[1] = 0;
+   outTargets = malloc((offsets[n + 1] + 1) * sizeof(int));
+   for( int u = 1; u <= n; u++ )
+   {
+      int k = outOffsets[u];
+      for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+      {
+         int v = targets[e];
+         if( (e == offsets[u] || targets[e - 1] != v)
+             && ( distinct[v] > distinct[u]
+                  || (distinct[v] == distinct[u] && v > u) ) )
+         {
+            outTargets[k++] = v;
+         }
+      }
+      outOffsets[u + 1] = k;
+   }
+   free(offsets);
+   free(targets);
+
+   if( triangles != NULL )
+   {
+      memset(triangles, 0, (n + 1) * sizeof(long long));
+   }
+   #pragma omp parallel for schedule(dynamic, 64) reduction(+:total)
+   for( int u = 1; u <= n; u++ )
+   {
+      int* outU = outTargets + outOffsets[u];
+      int degreeU = outOffsets[u + 1] - outOffsets[u];
+      long long found = 0;
+
+      for( int e = outOffsets[u]; e < outOffsets[u + 1]; e++ )
+      {
+         int v = outTargets[e];
+         int common = intersectLists(outU, degreeU,
+                                     outTargets + outOffsets[v],
+                                     outOffsets[v + 1] - outOffsets[v],
+                                     triangles);
+         if( triangles != NULL && common != 0 )
+         {
+            #pragma omp atomic
+            triangles[v] += common;
+         }
+         found += common;
+      }
+      if( triangles != NULL )
+      {
+         #pragma omp atomic
+         triangles[u] += found;
+      }
+      total += found;
+   }
+
+   free(outOffsets);
+   free(outTargets);
+   if( degree == NULL )
+   {
+      free(distinct);
+   }
+   return total;
+}
+
+// countTriangles()
+// Returns the number of triangles in G. If triangles is not NULL, stores in
+// triangles[1..n] the number of triangles each vertex belongs to.
+long long countTriangles(Graph G, long long* triangles)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling countTriangles() on NULL Graph"
+             " reference.\n");
+      exit(1);
+   }
+   return triangleCensus(G, triangles, NULL);
+}
+
+// localClustering()
+// Stores in coefficients[1..n] the local clustering coefficient of every
+// vertex: the fraction of pairs of its neighbors that are adjacent. Vertices
+// with fewer than two neighbors get 0.
+void localClustering(Graph G, double* coefficients)
+{
+   if( G==NULL || coefficients==NULL )
+   {
+      printf("Graph Error: calling localClustering() on NULL Graph or"
+             " coefficients reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   long long* triangles = malloc((n + 1) * sizeof(long long));
+   int* degree = malloc((n + 1) * sizeof(int));
+
+   triangleCensus(G, triangles, degree);
+   for( int v = 1; v <= n; v++ )
+   {
+      double pairs = (double)degree[v] * (degree[v] - 1) / 2.0;
+      coefficients[v] = (pairs > 0) ? triangles[v] / pairs : 0.0;
+   }
+
+   free(triangles);
+   free(degree);
+}
+
+// transitivity()
+// Returns the global clustering coefficient of G, three times the number of
+// triangles over the number of paths of length two, or 0 if there are none.
+double transitivity(Graph G)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling transitivity() on NULL Graph reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int* degree = malloc((n + 1) * sizeof(int));
+   long long total = triangleCensus(G, NULL, degree);
+   double paths = 0.0;
+
+   for( int v = 1; v <= n; v++ )
+   {
+      paths += (double)degree[v] * (degree[v] - 1) / 2.0;
+   }
+   free(degree);
+   return (paths > 0) ? 3.0 * total / paths : 0.0;
+}
+
+// Vertex reordering ----------------------------------------------------------
+
+// sortByDegree()
+// Sorts vertices[0..count - 1] by increasing length of their range in
+// offsets, or decreasing if descending is true, breaking ties by label.
+// Private.
+void sortByDegree(int* vertices, int count, int* offsets, bool descending)
+{
+   // Insertion sort for the short runs of neighbors that RCM sorts.
+   if( count <= 16 )
+   {
+      for( int i = 1; i < count; i++ )
+      {
+         int v = vertices[i];
+         int degreeV = offsets[v + 1] - offsets[v];
+         int j = i - 1;
+         while( j >= 0 )
+         {
+            int degreeJ = offsets[vertices[j] + 1] - offsets[vertices[j]];
+            bool isAfter = descending ? (degreeJ < degreeV)
+                                      : (degreeJ > degreeV);
+            if( !isAfter && !(degreeJ == degreeV && vertices[j] > v) )
+            {
+               break;
+            }
+            vertices[j + 1] = vertices[j];
+            j--;
+         }
+         vertices[j + 1] = v;
+      }
+      return;
+   }
+   // Longer runs are sorted by a counting sort on the degree, which keeps
+   // the increasing labels of equal degree vertices.
+   int maxDegree = 0;
+   for( int i = 0; i < count; i++ )
+   {
+      int degree = offsets[vertices[i] + 1] - offsets[vertices[i]];
+      if( degree > maxDegree )
+      {
+         maxDegree = degree;
+      }
+   }
+   int* start = calloc(maxDegree + 2, sizeof(int));
+   int* sorted = malloc(count * sizeof(int));
+
+   qsort(vertices, count, sizeof(int), compareVertices);
+   for( int i = 0; i < count; i++ )
+   {
+      int degree = offsets[vertices[i] + 1] - offsets[vertices[i]];
+      start[(descending ? maxDegree - degree : degree) + 1]++;
+   }
+   for( int d = 1; d <= maxDegree + 1; d++ )
+   {
+      start[d] += start[d - 1];
+   }
+   for( int i = 0; i < count; i++ )
+   {
+      int degree = offsets[vertices[i] + 1] - offsets[vertices[i]];
+      sorted[start[descending ? maxDegree - degree : degree]++] = vertices[i];
+   }
+   memcpy(vertices, sorted, count * sizeof(int));
+   free(start);
+   free(sorted);
+}
+
+// breadthFirstOrder()
+// Stores in order[0..n - 1] the vertices in the order a breadth first search
+// reaches them, restarting from a new root for every component. Roots are
+// the lowest labelled unreached vertex, or the unreached vertex of least
+// degree if byDegree is true, in which case the neighbors of every vertex are
+// also queued by increasing degree (the Cuthill-McKee order). Private.
+void breadthFirstOrder(int n, int* offsets, int* targets, bool byDegree,
+                       int* order)
+{
+   bool* reached = calloc(n + 1, sizeof(bool));
+   int* roots = malloc(n * sizeof(int));
+   int head = 0, tail = 0;
+
+   for( int v = 1; v <= n; v++ )
+   {
+      roots[v - 1] = v;
+   }
+   if( byDegree )
+   {
+      sortByDegree(roots, n, offsets, false);
+   }
+   for( int r = 0; r < n; r++ )
+   {
+      if( reached[roots[r]] )
+      {
+         continue;
+      }
+      reached[roots[r]] = true;
+      order[tail++] = roots[r];
+      while( head < tail )
+      {
+         int u = order[head++];
+         int firstQueued = tail;
+         for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+         {
+            if( !reached[targets[e]] )
+            {
+               reached[targets[e]] = true;
+               order[tail++] = targets[e];
+            }
+         }
+         if( byDegree )
+         {
+            sortByDegree(order + firstQueued, tail - firstQueued, offsets,
+                         false);
+         }
+      }
+   }
+   free(reached);
+   free(roots);
+}
+
+// computeOrdering()
+// Computes a relabelling of the vertices of G that places neighbors close
+// together. method is REVERSE_CUTHILL_MCKEE, DEGREE_ORDER (decreasing
+// degree) or BFS_ORDER. Stores in newLabel[1..n] the new label of every
+// vertex and, if oldLabel is not NULL, stores in oldLabel[1..n] the vertex
+// that every new label came from.
+void computeOrdering(Graph G, int method, int* newLabel, int* oldLabel)
+{
+   if( G==NULL || newLabel==NULL )
+   {
+      printf("Graph Error: calling computeOrdering() on NULL Graph or label"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int *offsets, *targets;
+   int* order = malloc(n * sizeof(int));
+
+   buildAdjacencyArrays(G, &offsets, &targets);
+   if( method == REVERSE_CUTHILL_MCKEE )
+   {
+      breadthFirstOrder(n, offsets, targets, true, order);
+      for( int i = 0; i < n / 2; i++ )
+      {
+         int temp = order[i];
+         order[i] = order[n - 1 - i];
+         order[n - 1 - i] = temp;
+      }
+   }
+   else if( method == DEGREE_ORDER )
+   {
+      for( int v = 1; v <= n; v++ )
+      {
+         order[v - 1] = v;
+      }
+      sortByDegree(order, n, offsets, true);
+   }
+   else if( method == BFS_ORDER )
+   {
+      breadthFirstOrder(n, offsets, targets, false, order);
+   }
+   else
+   {
+      printf("Graph Error: calling computeOrdering() with an unknown"
+             " method.\n");
+      exit(1);
+   }
+   for( int i = 0; i < n; i++ )
+   {
+      newLabel[order[i]] = i + 1;
+      if( oldLabel != NULL )
+      {
+         oldLabel[i + 1] = order[i];
+      }
+   }
+
+   free(offsets);
+   free(targets);
+   free(order);
+}
+
+// relabelGraph()
+// Returns a new graph where every vertex u of G is renamed newLabel[u]. The
+// size is kept and the adjacency lists stay in increasing order.
+// Precondition: newLabel[1..n] is a permutation of 1..n.
+Graph relabelGraph(Graph G, int* newLabel)
+{
+   if( G==NULL || newLabel==NULL )
+   {
+      printf("Graph Error: calling relabelGraph() on NULL Graph or label"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int *offsets, *targets;
+   Graph R = newGraph(n);
+
+   buildAdjacencyArrays(G, &offsets, &targets);
+
+   #pragma omp parallel for schedule(dynamic, 64)
+   for( int u = 1; u <= n; u++ )
+   {
+      int* renamed = targets + offsets[u];
+      int degree = offsets[u + 1] - offsets[u];
+
+      for( int e = 0; e < degree; e++ )
+      {
+         renamed[e] = newLabel[renamed[e]];
+      }
+      qsort(renamed, degree, sizeof(int), compareVertices);
+      for( int e = 0; e < degree; e++ )
+      {
+         IntListAppend(R->neighbors[newLabel[u]], renamed[e]);
+      }
+   }
+   R->size = G->size;
+
+   free(offsets);
+   free(targets);
+   return R;
+}
+
+// adjacencyMatrix()
+// Returns a new compressed Matrix with an entry 1.0 at (u, v) for every arc
+// u -> v of G, for matrixBFS() and the semiring products.
+Matrix adjacencyMatrix(Graph G)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling adjacencyMatrix() on NULL Graph"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int *offsets, *targets;
+   int* sources;
+   double* ones;
+   Matrix A;
+
+   buildAdjacencyArrays(G, &offsets, &targets);
+   sources = malloc((offsets[n + 1] + 1) * sizeof(int));
+   ones = malloc((offsets[n + 1] + 1) * sizeof(double));
+   for( int u = 1; u <= n; u++ )
+   {
+      for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+      {
+         sources[e] = u;
+         ones[e] = 1.0;
+      }
+   }
+   A = buildCompressedMatrix(n, sources, targets, ones, offsets[n + 1]);
+
+   free(offsets);
+   free(targets);
+   free(sources);
+   free(ones);
+   return A;
+}
+
+// Helper Functions -----------------------------------------------------------
+
+// buildAdjacencyArrays()
+// Copies the adjacency lists of G into two contiguous arrays. The neighbors
+// of vertex u are (*pTargets)[(*pOffsets)[u]] up to but not including
+// (*pTargets)[(*pOffsets)[u + 1]]. The caller frees both arrays.
+// Precondition: G stores at most INT_MAX arcs; buildWideAdjacencyArrays()
+// has no such limit.
+void buildAdjacencyArrays(Graph G, int** pOffsets, int** pTargets)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling buildAdjacencyArrays() on NULL Graph"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   int* offsets = malloc((n + 2) * sizeof(int));
+   int* targets;
+   long long arcs = 0;
+
+   offsets[0] = offsets[1] = 0;
+   for( int u = 1; u <= n; u++ )
+   {
+      arcs += IntListLength(G->neighbors[u]);
+      if( arcs > INT_MAX )
+      {
+         printf("Graph Error: calling buildAdjacencyArrays() on a Graph"
+                " with more than INT_MAX arcs.\n");
+         exit(1);
+      }
+      offsets[u + 1] = (int)arcs;
+   }
+   targets = malloc((offsets[n + 1] + 1) * sizeof(int));
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int u = 1; u <= n; u++ )
+   {
+      int e = offsets[u];
+      for( IntListIterator I = IntListBegin(G->neighbors[u]);
+           !IntListAtEnd(I); IntListIteratorNext(&I) )
+      {
+         targets[e++] = IntListIteratorGet(I);
+      }
+   }
+   *pOffsets = offsets;
+   *pTargets = targets;
+}
+
+// buildWideAdjacencyArrays()
+// Same as buildAdjacencyArrays(), with 64 bit offsets so that G may store
+// more than INT_MAX arcs.
+void buildWideAdjacencyArrays(Graph G, long long** pOffsets, int** pTargets)
+{
+   if( G==NULL )
+   {
+      printf("Graph Error: calling buildWideAdjacencyArrays() on NULL Graph"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   long long* offsets = malloc((n + 2) * sizeof(long long));
+   int* targets;
+
+   offsets[0] = offsets[1] = 0;
+   for( int u = 1; u <= n; u++ )
+   {
+      offsets[u + 1] = offsets[u] + IntListLength(G->neighbors[u]);
+   }
+   targets = malloc((offsets[n + 1] + 1) * sizeof(int));
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int u = 1; u <= n; u++ )
+   {
+      long long e = offsets[u];
+      for( IntListIterator I = IntListBegin(G->neighbors[u]);
+           !IntListAtEnd(I); IntListIteratorNext(&I) )
+      {
+         targets[e++] = IntListIteratorGet(I);
+      }
+   }
+   *pOffsets = offsets;
+   *pTargets = targets;
+}
+
+// buildReverseArrays()
+// Builds the arrays of the reversed arcs of the n vertex graph stored in
+// offsets and targets, listing the sources of each vertex in increasing
+// order. If weights is not NULL the weight of every arc is carried over to
+// *pWeights. The caller frees the new arrays.
+void buildReverseArrays(int n, int* offsets, int* targets, double* weights,
+                        int** pOffsets, int** pSources, double** pWeights)
+{
+   int arcs = offsets[n + 1];
+   int* reverseOffsets = calloc(n + 2, sizeof(int));
+   int* sources = malloc((arcs + 1) * sizeof(int));
+   int* next = malloc((n + 2) * sizeof(int));
+   double* reverseWeights = NULL;
+
+   if( weights != NULL )
+   {
+      reverseWeights = malloc((arcs + 1) * sizeof(double));
+   }
+   for( int e = 0; e < arcs; e++ )
+   {
+      reverseOffsets[targets[e] + 1]++;
+   }
+   for( int v = 1; v <= n; v++ )
+   {
+      reverseOffsets[v + 1] += reverseOffsets[v];
+   }
+   memcpy(next, reverseOffsets, (n + 2) * sizeof(int));
+   for( int u = 1; u <= n; u++ )
+   {
+      for( int e = offsets[u]; e < offsets[u + 1]; e++ )
+      {
+         int slot = next[targets[e]]++;
+         sources[slot] = u;
+         if( weights != NULL )
+         {
+            reverseWeights[slot] = weights[e];
+         }
+      }
+   }
+   free(next);
+
+   *pOffsets = reverseOffsets;
+   *pSources = sources;
+   if( pWeights != NULL )
+   {
+      *pWeights = reverseWeights;
+   }
+}
@@ -6,11 +6,15 @@
 #ifndef _GRAPH_H_INCLUDE_
 #define _GRAPH_H_INCLUDE_
 #include<stdio.h>
+#include<stdbool.h>
 #include "Heap.h"
 #include "Matrix.h"
 #include "IntList.h"
 #define NIL  0
 #define INF  -2
+#define REVERSE_CUTHILL_MCKEE 1
+#define DEGREE_ORDER 2
+#define BFS_ORDER 3
 typedef struct GraphObj* Graph;
 
 // Constructors-Destructors ---------------------------------------------------
@@ -33,6 +37,11 @@ int getGraphOrder(Graph G);
 // Returns the size of the graph (the number of edges).
 int getGraphSize(Graph G);
 
+// graphMemoryUsage()
+// Returns the bytes held by G: the adjacency lists and their nodes, the
+// array of lists and the graphObj itself, and the BFS() state arrays.
+MemoryUsage graphMemoryUsage(Graph G);
+
 // getSource()
 // Returns the vertex that was most recently the source of BFS() or NIL
 // if BFS() has never been called.
@@ -74,6 +83,22 @@ void addEdge(Graph G, int u, int v);
 // Precondtiion: both int arguments must be between 1 and the size of the graph.
 void addArc(Graph G, int u, int v);
 
+// addEdges()
+// Inserts count edges at once, the i-th joining sources[i] and targets[i],
+// or arcs from sources[i] to targets[i] if isDirected is true. Leaves G as
+// the same sequence of addEdge() or addArc() calls would, but merges a
+// sorted batch into every adjacency list in a single pass, in parallel.
+// Precondition: all vertices must be between 1 and the order of the graph,
+// the batch holds at most INT_MAX arcs and the graph INT_MAX edges.
+void addEdges(Graph G, int* sources, int* targets, int count,
+              bool isDirected);
+
+// buildGraph()
+// Returns a graph with n vertices holding the count edges (or arcs) given
+// as in addEdges().
+Graph buildGraph(int n, int* sources, int* targets, int count,
+                 bool isDirected);
+
 // BFS()
 // Implements the breadth first search algorithm.
 // precondition source is not out of bounds.
@@ -94,8 +119,109 @@ void initialize(Graph G, int source);
 // path change the distance reported by vertex Y.
 void relax(Heap H, Graph G, Matrix weights, int vertexX, int vertexY);
 
-// printGraph()
-// Prints the adjacency list representation of the graph.
-void printGraph(FILE* out, Graph G);
+// graphToString()
+// Writes the adjacency list representation of the graph to out, one
+// "u: neighbors" line per vertex, through a large buffer.
+void graphToString(FILE* out, Graph G);
+
+// writeGraphSegments()
+// Writes the lines of graphToString() to segmentCount files named
+// pathPrefix.0, pathPrefix.1, ... in parallel, splitting the vertices into
+// ranges of about the same output size. Concatenated in order, the files
+// hold exactly what graphToString() writes. Returns false if a file could
+// not be written.
+bool writeGraphSegments(Graph G, const char* pathPrefix, int segmentCount);
+
+// Directed acyclic graph algorithms ------------------------------------------
+
+// topologicalSort()
+// Runs Kahn's algorithm on the arcs of G, processing each frontier of
+// in-degree zero vertices in parallel. If G is acyclic, appends its vertices
+// to L in topological order and returns true. Otherwise appends to L the
+// vertices v1 v2 ... vk of one directed cycle (vk has an arc to v1) and
+// returns false.
+bool topologicalSort(IntList L, Graph G);
+
+// criticalPath()
+// Appends to L the vertices of a longest path in the DAG G and returns its
+// length. The weight of the arc u->v is getMatrixEntryData(weights, u, v),
+// the same lookup relax() uses; every arc weighs 1 if weights is NULL.
+// Precondition: G has no directed cycles.
+double criticalPath(IntList L, Graph G, Matrix weights);
+
+// Ranking algorithms ---------------------------------------------------------
+
+// pageRank()
+// Stores in ranks[1..n] the PageRank of every vertex of G with the given
+// damping factor. Vertices without out-going arcs spread their rank evenly
+// over all vertices. Stops once an iteration changes the ranks by less than
+// tolerance (in the 1-norm) or after maxIterations, and returns the number
+// of iterations.
+int pageRank(Graph G, double damping, double tolerance, int maxIterations,
+             double* ranks);
+
+// Triangle algorithms --------------------------------------------------------
+// These treat G as undirected, so every edge must have been added with
+// addEdge(). Self loops and repeated edges are ignored.
+
+// countTriangles()
+// Returns the number of triangles in G. If triangles is not NULL, stores in
+// triangles[1..n] the number of triangles each vertex belongs to.
+long long countTriangles(Graph G, long long* triangles);
+
+// localClustering()
+// Stores in coefficients[1..n] the local clustering coefficient of every
+// vertex: the fraction of pairs of its neighbors that are adjacent. Vertices
+// with fewer than two neighbors get 0.
+void localClustering(Graph G, double* coefficients);
+
+// transitivity()
+// Returns the global clustering coefficient of G, three times the number of
+// triangles over the number of paths of length two, or 0 if there are none.
+double transitivity(Graph G);
+
+// Vertex reordering ----------------------------------------------------------
+
+// computeOrdering()
+// Computes a relabelling of the vertices of G that places neighbors close
+// together. method is REVERSE_CUTHILL_MCKEE, DEGREE_ORDER (decreasing
+// degree) or BFS_ORDER. Stores in newLabel[1..n] the new label of every
+// vertex and, if oldLabel is not NULL, stores in oldLabel[1..n] the vertex
+// that every new label came from.
+void computeOrdering(Graph G, int method, int* newLabel, int* oldLabel);
+
+// relabelGraph()
+// Returns a new graph where every vertex u of G is renamed newLabel[u]. The
+// size is kept and the adjacency lists stay in increasing order.
+// Precondition: newLabel[1..n] is a permutation of 1..n.
+Graph relabelGraph(Graph G, int* newLabel);
+
+// adjacencyMatrix()
+// Returns a new compressed Matrix with an entry 1.0 at (u, v) for every arc
+// u -> v of G, for matrixBFS() and the semiring products.
+Matrix adjacencyMatrix(Graph G);
+
+// Helper Functions -----------------------------------------------------------
+
+// buildAdjacencyArrays()
+// Copies the adjacency lists of G into two contiguous arrays. The neighbors
+// of vertex u are (*pTargets)[(*pOffsets)[u]] up to but not including
+// (*pTargets)[(*pOffsets)[u + 1]]. The caller frees both arrays.
+// Precondition: G stores at most INT_MAX arcs; buildWideAdjacencyArrays()
+// has no such limit.
+void buildAdjacencyArrays(Graph G, int** pOffsets, int** pTargets);
+
+// buildWideAdjacencyArrays()
+// Same as buildAdjacencyArrays(), with 64 bit offsets so that G may store
+// more than INT_MAX arcs.
+void buildWideAdjacencyArrays(Graph G, long long** pOffsets, int** pTargets);
+
+// buildReverseArrays()
+// Builds the arrays of the reversed arcs of the n vertex graph stored in
+// offsets and targets, listing the sources of each vertex in increasing
+// order. If weights is not NULL the weight of every arc is carried over to
+// *pWeights. The caller frees the new arrays.
+void buildReverseArrays(int n, int* offsets, int* targets, double* weights,
+                        int** pOffsets, int** pSources, double** pWeights);
 
 #endif
@@ -4,12 +4,46 @@
 //-----------------------------------------------------------------------------
 #include<stdio.h>
 #include<stdlib.h>
+#include<string.h>
 #include"IntList.h"
 #include"Graph.h"
+#include"GraphStream.h"
 #include"Matrix.h"
 
+// streamClient()
+// Builds a graph of the given order from edge lines piped to stdin, then
+// prints it, the ingest counters and the memory it takes.
+int streamClient(int order)
+{
+   Graph G = newGraph(order);
+   GraphStream S = newGraphStream(G, 1 << 20, false);
+
+   streamEdges(S, stdin);
+   graphToString(stdout, G);
+   fprintf(stderr, "%lld edges, %.0f edges/sec, %d merges in %f seconds\n",
+           getStreamedEdges(S), getStreamRate(S), getStreamMerges(S),
+           getStreamMergeSeconds(S));
+   if( getStreamMalformed(S) > 0 )
+   {
+      fprintf(stderr, "%lld malformed lines skipped\n",
+              getStreamMalformed(S));
+   }
+   printMemoryUsage(stderr, "graph", graphMemoryUsage(G));
+   fprintf(stderr, "peak allocated: %zu bytes\n", getPeakAllocatedBytes());
+
+   freeGraphStream(&S);
+   freeGraph(&G);
+   return(0);
+}
+
 int main(int argc, char* argv[])
 {
+   // GraphClient --stream n < edges.txt
+   if( argc == 3 && strcmp(argv[1], "--stream") == 0 )
+   {
+      return streamClient(atoi(argv[2]));
+   }
+
    Graph A = newGraph(4);
    Graph B = newGraph(6);
    Graph C = NULL;
@@ -29,7 +63,7 @@ int main(int argc, char* argv[])
    graphToString(stdout, A);                               
    for( int i = 1; i <= getGraphOrder(A); i++ )
    {
-      moveFront(path);
+      IntListMoveFront(path);
       printf("\n\nRunning BFS() with source %d\n", i);
       BFS(A, i);
 
@@ -83,7 +117,7 @@ int main(int argc, char* argv[])
          getPath(path, B, k);
          intListToString(stdout, path);
          printf("\n");
-         clear(path);
+         IntListClear(path);
       }
    }
 
@@ -122,7 +156,7 @@ int main(int argc, char* argv[])
          getPath(path, D, k);
          intListToString(stdout, path);
          printf("\n");
-         clear(path);
+         IntListClear(path);
       }
    }
    
@@ -0,0 +1,470 @@
+//-----------------------------------------------------------------------------
+// GraphReader.c
+// Implementation file for reading graphs from edge list text files.
+//-----------------------------------------------------------------------------
+
+#include<fcntl.h>
+#include<limits.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#ifdef _OPENMP
+#include<omp.h>
+#endif
+#include "GraphReader.h"
+
+// MIN_CHUNK_LENGTH is the smallest number of bytes worth its own chunk.
+#define MIN_CHUNK_LENGTH 65536
+
+// MAX_CHUNK_LENGTH is the largest chunk, small enough that the lines in a
+// chunk can be counted in an int.
+#define MAX_CHUNK_LENGTH (1 << 30)
+
+// structs --------------------------------------------------------------------
+
+// private ParsedChunk type, the edges found in one chunk of the file
+typedef struct ParsedChunk
+{
+   const char* begin;
+   const char* end;
+   int* sources;
+   int* targets;
+   double* weights;
+   int count;
+   int maxVertex;
+   const char* malformed;    // first bad line, or NULL
+} ParsedChunk;
+
+// Number parsing -------------------------------------------------------------
+
+// isBlank()
+// Returns true for the characters that separate fields. Private.
+bool isBlank(char c)
+{
+   return c == ' ' || c == '\t' || c == '\r';
+}
+
+// skipBlanks()
+// Returns the first position at or after p that is not a blank. Private.
+const char* skipBlanks(const char* p, const char* end)
+{
+   while( p < end && isBlank(*p) )
+   {
+      p++;
+   }
+   return p;
+}
+
+// parseVertex()
+// Parses the positive decimal number at *pp into *pV and advances *pp past
+// it. Returns false if there is no number or it does not fit in an int.
+// Private.
+bool parseVertex(const char** pp, const char* end, int* pV)
+{
+   const char* p = *pp;
+   long long value = 0;
+
+   if( p == end || *p < '0' || *p > '9' )
+   {
+      return false;
+   }
+   while( p < end && *p >= '0' && *p <= '9' )
+   {
+      value = value * 10 + (*p++ - '0');
+      if( value > INT_MAX )
+      {
+         return false;
+      }
+   }
+   *pp = p;
+   *pV = (int)value;
+   return true;
+}
+
+// parseWeight()
+// Parses the decimal number at *pp into *pW and advances *pp past it.
+// When the digits form an integer of at most 2^53 and there are at most 22
+// digits after the point, both that integer and the power of ten are exact
+// doubles, so one division rounds the result correctly, as in Clinger's
+// algorithm; anything else is handed to strtod(). Returns false if there is
+// no number. Private.
+bool parseWeight(const char** pp, const char* end, double* pW)
+{
+   static const double powersOfTen[] =
+   {
+      1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+   };
+   const char* p = *pp;
+   const char* token = p;
+   unsigned long long mantissa = 0;
+   int digits = 0, exponent = 0;
+   bool isNegative = false, isSimple = true;
+
+   if( p < end && (*p == '-' || *p == '+') )
+   {
+      isNegative = (*p++ == '-');
+   }
+   for( ; p < end && *p >= '0' && *p <= '9'; p++, digits++ )
+   {
+      mantissa = mantissa * 10 + (*p - '0');
+   }
+   if( p < end && *p == '.' )
+   {
+      for( p++; p < end && *p >= '0' && *p <= '9'; p++, digits++ )
+      {
+         mantissa = mantissa * 10 + (*p - '0');
+         exponent--;
+      }
+   }
+   if( digits == 0 )
+   {
+      return false;
+   }
+   if( p < end && (*p == 'e' || *p == 'E') )
+   {
+      isSimple = false;
+      for( p++; p < end && !isBlank(*p) && *p != '\n'; p++ );
+   }
+   if( isSimple && digits <= 18 && mantissa <= (1ULL << 53)
+       && exponent >= -22 )
+   {
+      *pW = (double)mantissa / powersOfTen[-exponent];
+   }
+   else
+   {
+      char buffer[64];
+      size_t length = p - token;
+
+      if( length >= sizeof(buffer) )
+      {
+         return false;
+      }
+      memcpy(buffer, token, length);
+      buffer[length] = '\0';
+      *pW = strtod(buffer, NULL);
+      isNegative = false;
+   }
+   if( isNegative )
+   {
+      *pW = -*pW;
+   }
+   *pp = p;
+   return true;
+}
+
+// Chunk parsing --------------------------------------------------------------
+
+// countLines()
+// Returns the number of lines that start in [begin, end). Private.
+long long countLines(const char* begin, const char* end)
+{
+   long long lines = 0;
+   const char* p = begin;
+
+   while( p < end )
+   {
+      const char* newline = memchr(p, '\n', end - p);
+      lines++;
+      if( newline == NULL )
+      {
+         break;
+      }
+      p = newline + 1;
+   }
+   return lines;
+}
+
+// parseEdgeLine()
+// Parses the line starting at *pp, which ends at the next newline or at end,
+// and advances *pp to the start of the next line. Returns LINE_EDGE and sets
+// *pU, *pV and *pW (1 if the line has no weight) if the line is an edge,
+// LINE_ORDER and sets *pU if it holds a single number, LINE_EMPTY for blank
+// and comment lines and LINE_MALFORMED otherwise.
+int parseEdgeLine(const char** pp, const char* end, int* pU, int* pV,
+                  double* pW)
+{
+   const char* p = skipBlanks(*pp, end);
+   const char* newline = memchr(p, '\n', end - p);
+   int kind = LINE_MALFORMED;
+
+   *pp = (newline == NULL) ? end : newline + 1;
+   if( p == end || *p == '\n' || *p == '#' || *p == '%' )
+   {
+      return LINE_EMPTY;
+   }
+   *pW = 1.0;
+   if( parseVertex(&p, end, pU) )
+   {
+      p = skipBlanks(p, end);
+      if( p == end || *p == '\n' )
+      {
+         return LINE_ORDER;
+      }
+      if( *pU != 0 && parseVertex(&p, end, pV) && *pV != 0 )
+      {
+         p = skipBlanks(p, end);
+         if( p < end && *p != '\n' && parseWeight(&p, end, pW) )
+         {
+            p = skipBlanks(p, end);
+         }
+         if( p == end || *p == '\n' )
+         {
+            kind = LINE_EDGE;
+         }
+      }
+   }
+   return kind;
+}
+
+// parseChunk()
+// Parses the edges in C->begin up to C->end into the arrays of C, which
+// have room for one edge per line. Stops at the first malformed line and
+// records it in C->malformed; only the header may hold a single number.
+// Private.
+void parseChunk(ParsedChunk* C)
+{
+   const char* p = C->begin;
+
+   C->count = 0;
+   C->maxVertex = 0;
+   C->malformed = NULL;
+   while( p < C->end )
+   {
+      const char* line = p;
+      int u, v;
+      double w;
+      int kind = parseEdgeLine(&p, C->end, &u, &v, &w);
+
+      if( kind == LINE_MALFORMED || kind == LINE_ORDER )
+      {
+         C->malformed = line;
+         return;
+      }
+      if( kind == LINE_EDGE )
+      {
+         C->sources[C->count] = u;
+         C->targets[C->count] = v;
+         C->weights[C->count] = w;
+         C->count++;
+         if( u > C->maxVertex )
+         {
+            C->maxVertex = u;
+         }
+         if( v > C->maxVertex )
+         {
+            C->maxVertex = v;
+         }
+      }
+   }
+}
+
+// readHeader()
+// Skips the comments at the top of the text and, if the first line with
+// data holds a single number, stores it in *pOrder and skips that line too.
+// Returns where the edges begin. Private.
+const char* readHeader(const char* text, const char* end, int* pOrder)
+{
+   const char* p = text;
+
+   *pOrder = 0;
+   while( p < end )
+   {
+      const char* line = p;
+      const char* newline = memchr(p, '\n', end - p);
+      const char* lineEnd = (newline == NULL) ? end : newline;
+      int order;
+
+      p = skipBlanks(p, end);
+      if( p < lineEnd && *p != '#' && *p != '%' )
+      {
+         if( parseVertex(&p, end, &order) && skipBlanks(p, end) == lineEnd )
+         {
+            *pOrder = order;
+            return (newline == NULL) ? end : newline + 1;
+         }
+         return line;
+      }
+      p = (newline == NULL) ? end : newline + 1;
+   }
+   return p;
+}
+
+// readEdgeList()
+// Returns the graph described by the edge list at path, adding every line
+// as an edge, or as an arc if isDirected is true. If pWeights is not NULL,
+// *pWeights is set to a Matrix holding the weight of every arc u->v at
+// getMatrixEntryData(*pWeights, u, v), the lookup relax() uses; lines
+// without a weight weigh 1. Returns NULL if the file cannot be read.
+// The file is parsed in parallel, in chunks split at line boundaries.
+Graph readEdgeList(const char* path, bool isDirected, Matrix* pWeights)
+{
+   if( path == NULL )
+   {
+      printf("GraphReader Error: calling readEdgeList() on NULL path.\n");
+      exit(1);
+   }
+   struct stat status;
+   const char *text, *end, *body;
+   int descriptor = open(path, O_RDONLY);
+   int chunkCount = 1, count, order = 0, maxVertex = 0;
+   long long total = 0, arcs;
+   ParsedChunk* chunks;
+   int *sources, *targets;
+   double* weights;
+   Graph G;
+
+   if( descriptor < 0 || fstat(descriptor, &status) != 0 )
+   {
+      if( descriptor >= 0 )
+      {
+         close(descriptor);
+      }
+      return NULL;
+   }
+   text = "";
+   if( status.st_size > 0 )
+   {
+      text = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+   }
+   close(descriptor);
+   if( text == MAP_FAILED )
+   {
+      return NULL;
+   }
+   end = text + status.st_size;
+   body = readHeader(text, end, &order);
+
+#ifdef _OPENMP
+   chunkCount = 4 * omp_get_max_threads();
+#endif
+   if( chunkCount > (end - body) / MIN_CHUNK_LENGTH + 1 )
+   {
+      chunkCount = (end - body) / MIN_CHUNK_LENGTH + 1;
+   }
+   if( chunkCount < (end - body) / MAX_CHUNK_LENGTH + 1 )
+   {
+      chunkCount = (end - body) / MAX_CHUNK_LENGTH + 1;
+   }
+
+   // Cut the body into chunks that begin right after a newline.
+   chunks = calloc(chunkCount, sizeof(ParsedChunk));
+   for( int c = 0; c < chunkCount; c++ )
+   {
+      const char* begin = body + (end - body) / chunkCount * c;
+      if( c > 0 )
+      {
+         const char* newline = memchr(begin, '\n', end - begin);
+         begin = (newline == NULL) ? end : newline + 1;
+         if( begin < chunks[c - 1].begin )
+         {
+            begin = chunks[c - 1].begin;
+         }
+         chunks[c - 1].end = begin;
+      }
+      chunks[c].begin = begin;
+      chunks[c].end = end;
+   }
+
+   #pragma omp parallel for schedule(dynamic, 1)
+   for( int c = 0; c < chunkCount; c++ )
+   {
+      int lines = (int)countLines(chunks[c].begin, chunks[c].end);
+      chunks[c].sources = malloc((lines + 1) * sizeof(int));
+      chunks[c].targets = malloc((lines + 1) * sizeof(int));
+      chunks[c].weights = malloc((lines + 1) * sizeof(double));
+      parseChunk(&chunks[c]);
+   }
+
+   for( int c = 0; c < chunkCount; c++ )
+   {
+      if( chunks[c].malformed != NULL )
+      {
+         printf("GraphReader Error: malformed edge on line %lld of %s.\n",
+                countLines(text, chunks[c].malformed) + 1, path);
+         exit(1);
+      }
+      if( chunks[c].maxVertex > maxVertex )
+      {
+         maxVertex = chunks[c].maxVertex;
+      }
+      total += chunks[c].count;
+   }
+   arcs = isDirected ? total : 2 * total;
+   if( arcs > INT_MAX )
+   {
+      printf("GraphReader Error: %s holds %lld arcs, more than the INT_MAX a"
+             " Graph can hold.\n", path, arcs);
+      exit(1);
+   }
+   count = (int)total;
+   if( order == 0 )
+   {
+      order = maxVertex;
+   }
+   else if( maxVertex > order )
+   {
+      printf("GraphReader Error: vertex %d of %s is above the order %d given"
+             " in its header.\n", maxVertex, path, order);
+      exit(1);
+   }
+
+   // Gather the chunks into one edge array for the bulk build.
+   sources = malloc((count + 1) * sizeof(int));
+   targets = malloc((count + 1) * sizeof(int));
+   weights = malloc((count + 1) * sizeof(double));
+   for( int c = 0, at = 0; c < chunkCount; c++ )
+   {
+      int copied = chunks[c].count;
+      memcpy(sources + at, chunks[c].sources, copied * sizeof(int));
+      memcpy(targets + at, chunks[c].targets, copied * sizeof(int));
+      memcpy(weights + at, chunks[c].weights, copied * sizeof(double));
+      at += copied;
+      free(chunks[c].sources);
+      free(chunks[c].targets);
+      free(chunks[c].weights);
+   }
+   free(chunks);
+   if( status.st_size > 0 )
+   {
+      munmap((void*)text, status.st_size);
+   }
+
+   G = buildGraph(order, sources, targets, count, isDirected);
+   if( pWeights != NULL )
+   {
+      *pWeights = NULL;
+      if( order >= 1 )
+      {
+         // relax() reads the weight of u->v from row v, column u.
+         int* rows = malloc((arcs + 1) * sizeof(int));
+         int* columns = malloc((arcs + 1) * sizeof(int));
+         double* values = malloc((arcs + 1) * sizeof(double));
+
+         for( int i = 0, k = 0; i < count; i++ )
+         {
+            rows[k] = targets[i];
+            columns[k] = sources[i];
+            values[k++] = weights[i];
+            if( !isDirected )
+            {
+               rows[k] = sources[i];
+               columns[k] = targets[i];
+               values[k++] = weights[i];
+            }
+         }
+         *pWeights = buildMatrix(order, rows, columns, values, (int)arcs);
+         free(rows);
+         free(columns);
+         free(values);
+      }
+   }
+
+   free(sources);
+   free(targets);
+   free(weights);
+   return G;
+}
@@ -0,0 +1,49 @@
+//-----------------------------------------------------------------------------
+// GraphReader.h
+// Header file for reading graphs from edge list text files.
+//
+// An edge list has one edge per line, written as two vertex numbers and an
+// optional weight separated by spaces or tabs:
+//
+//    # comment lines start with '#' or '%'
+//    5
+//    1 2
+//    2 3 0.75
+//
+// If the first line that is not a comment holds a single number, it is the
+// number of vertices. Otherwise the order of the graph is the largest vertex
+// number in the file.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPH_READER_H_INCLUDE_
+#define _GRAPH_READER_H_INCLUDE_
+#include<stdbool.h>
+#include "Graph.h"
+#include "Matrix.h"
+
+// readEdgeList()
+// Returns the graph described by the edge list at path, adding every line
+// as an edge, or as an arc if isDirected is true. If pWeights is not NULL,
+// *pWeights is set to a Matrix holding the weight of every arc u->v at
+// getMatrixEntryData(*pWeights, u, v), the lookup relax() uses; lines
+// without a weight weigh 1. Returns NULL if the file cannot be read.
+// The file is parsed in parallel, in chunks split at line boundaries.
+Graph readEdgeList(const char* path, bool isDirected, Matrix* pWeights);
+
+// Helper Functions -----------------------------------------------------------
+
+#define LINE_ORDER 2
+#define LINE_EDGE 1
+#define LINE_EMPTY 0
+#define LINE_MALFORMED -1
+
+// parseEdgeLine()
+// Parses the line starting at *pp, which ends at the next newline or at end,
+// and advances *pp to the start of the next line. Returns LINE_EDGE and sets
+// *pU, *pV and *pW (1 if the line has no weight) if the line is an edge,
+// LINE_ORDER and sets *pU if it holds a single number, LINE_EMPTY for blank
+// and comment lines and LINE_MALFORMED otherwise.
+int parseEdgeLine(const char** pp, const char* end, int* pU, int* pV,
+                  double* pW);
+
+#endif
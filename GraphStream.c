@@ -0,0 +1,357 @@
+//-----------------------------------------------------------------------------
+// GraphStream.c
+// Implementation file for the GraphStream ADT.
+//-----------------------------------------------------------------------------
+
+#define _POSIX_C_SOURCE 199309L   // clock_gettime()
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include "GraphReader.h"
+#include "GraphStream.h"
+
+// READ_BUFFER_LENGTH is the number of bytes read from the input at a time.
+#define READ_BUFFER_LENGTH 65536
+
+// structs --------------------------------------------------------------------
+
+// private GraphStreamObj type
+typedef struct GraphStreamObj
+{
+   Graph G;
+   bool isDirected;
+   int batchSize;
+   int buffered;
+   int* sources;
+   int* targets;
+
+   char* text;              // read buffer
+   int textLength;          // bytes of a partial line kept from last read
+   bool isPastHeader;       // a line other than a comment has been read
+   bool isSkippingLine;     // dropping the rest of an overlong line
+
+   long long edges;
+   long long malformed;
+   int merges;
+   double mergeSeconds;
+   double startTime;
+
+   BackpressureHook hook;
+   void* hookContext;
+} GraphStreamObj;
+
+// secondsNow()
+// Returns a monotonic time in seconds. Private.
+double secondsNow(void)
+{
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newGraphStream()
+// Returns a stream that adds edges (arcs if isDirected is true) to G,
+// merging them every batchSize edges.
+// Precondition: batchSize >= 1.
+GraphStream newGraphStream(Graph G, int batchSize, bool isDirected)
+{
+   if( G == NULL )
+   {
+      printf("GraphStream Error: calling newGraphStream() on NULL Graph"
+             " reference.\n");
+      exit(1);
+   }
+   if( batchSize < 1 )
+   {
+      printf("GraphStream Error: calling newGraphStream() with a batch size"
+             " below 1.\n");
+      exit(1);
+   }
+   GraphStream S = malloc(sizeof(GraphStreamObj));
+   S->G = G;
+   S->isDirected = isDirected;
+   S->batchSize = batchSize;
+   S->buffered = 0;
+   S->sources = malloc(batchSize * sizeof(int));
+   S->targets = malloc(batchSize * sizeof(int));
+   S->text = malloc(READ_BUFFER_LENGTH);
+   S->textLength = 0;
+   S->isPastHeader = false;
+   S->isSkippingLine = false;
+   S->edges = 0;
+   S->malformed = 0;
+   S->merges = 0;
+   S->mergeSeconds = 0.0;
+   S->startTime = secondsNow();
+   S->hook = NULL;
+   S->hookContext = NULL;
+   return S;
+}
+
+// freeGraphStream()
+// Merges any buffered edges, then frees *pS and sets it to NULL. The graph
+// is not freed.
+void freeGraphStream(GraphStream* pS)
+{
+   if( pS != NULL && *pS != NULL )
+   {
+      flushGraphStream(*pS);
+      free((*pS)->sources);
+      free((*pS)->targets);
+      free((*pS)->text);
+      free(*pS);
+      *pS = NULL;
+   }
+}
+
+// Access functions -----------------------------------------------------------
+
+// getStreamedEdges()
+// Returns the number of edges merged into the graph so far.
+long long getStreamedEdges(GraphStream S)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling getStreamedEdges() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   return S->edges;
+}
+
+// getStreamMalformed()
+// Returns the number of lines skipped because they are not edges of the
+// graph: malformed lines, lines longer than the read buffer and edges with
+// a vertex above the order of the graph.
+long long getStreamMalformed(GraphStream S)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling getStreamMalformed() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   return S->malformed;
+}
+
+// getStreamBuffered()
+// Returns the number of edges waiting for the next merge.
+int getStreamBuffered(GraphStream S)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling getStreamBuffered() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   return S->buffered;
+}
+
+// getStreamMerges()
+// Returns the number of merges done so far.
+int getStreamMerges(GraphStream S)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling getStreamMerges() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   return S->merges;
+}
+
+// getStreamMergeSeconds()
+// Returns the total time spent merging batches into the graph.
+double getStreamMergeSeconds(GraphStream S)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling getStreamMergeSeconds() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   return S->mergeSeconds;
+}
+
+// getStreamRate()
+// Returns the merged edges per second since the stream was created.
+double getStreamRate(GraphStream S)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling getStreamRate() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   double elapsed = secondsNow() - S->startTime;
+   return (elapsed > 0.0) ? S->edges / elapsed : 0.0;
+}
+
+// Manipulation procedures ----------------------------------------------------
+
+// setBackpressureHook()
+// Installs hook, called with context after every merge. NULL removes it.
+void setBackpressureHook(GraphStream S, BackpressureHook hook,
+                         void* context)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling setBackpressureHook() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   S->hook = hook;
+   S->hookContext = context;
+}
+
+// mergeBatch()
+// Merges the buffered edges and returns what the backpressure hook says,
+// or true if there is no hook. Private.
+bool mergeBatch(GraphStream S)
+{
+   double start = secondsNow();
+
+   addEdges(S->G, S->sources, S->targets, S->buffered, S->isDirected);
+   S->mergeSeconds += secondsNow() - start;
+   S->edges += S->buffered;
+   S->merges++;
+   S->buffered = 0;
+
+   return (S->hook == NULL) || S->hook(S, S->hookContext);
+}
+
+// streamEdge()
+// Buffers one edge, merging the batch if it becomes full. Returns false if
+// that merge made the backpressure hook return false, true otherwise.
+// Precondition: u and v are between 1 and the order of the graph.
+bool streamEdge(GraphStream S, int u, int v)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling streamEdge() on NULL GraphStream"
+             " reference.\n");
+      exit(1);
+   }
+   S->sources[S->buffered] = u;
+   S->targets[S->buffered] = v;
+   S->buffered++;
+   return (S->buffered < S->batchSize) || mergeBatch(S);
+}
+
+// streamEdges()
+// Reads edge lines from in until end of file or until the backpressure
+// hook returns false. Returns true at end of file. When the hook stops the
+// stream, the unparsed input is kept and the next call resumes from it.
+// A leading line holding only the number of vertices is skipped. Any other
+// line that is not an edge of the graph is skipped and counted by
+// getStreamMalformed(), so bad input never stops the stream.
+bool streamEdges(GraphStream S, FILE* in)
+{
+   if( S == NULL || in == NULL )
+   {
+      printf("GraphStream Error: calling streamEdges() on NULL GraphStream"
+             " or FILE reference.\n");
+      exit(1);
+   }
+   int order = getGraphOrder(S->G);
+   bool isEnd = false;
+
+   while( !isEnd )
+   {
+      size_t got = fread(S->text + S->textLength, 1,
+                         READ_BUFFER_LENGTH - S->textLength, in);
+      const char* p = S->text;
+      const char* end = S->text + S->textLength + got;
+      const char* complete = end;
+
+      isEnd = (got == 0);
+      if( S->isSkippingLine )
+      {
+         const char* newline = memchr(p, '\n', end - p);
+         if( newline == NULL )
+         {
+            S->textLength = 0;
+            continue;
+         }
+         S->isSkippingLine = false;
+         p = newline + 1;
+      }
+      if( !isEnd )
+      {
+         // Only parse up to the last newline; the rest waits for more input.
+         while( complete > p && complete[-1] != '\n' )
+         {
+            complete--;
+         }
+         if( complete == p )
+         {
+            if( end - p < READ_BUFFER_LENGTH )
+            {
+               S->textLength = end - p;
+               memmove(S->text, p, S->textLength);
+            }
+            else
+            {
+               // A line that fills the buffer cannot be an edge.
+               S->malformed++;
+               S->isSkippingLine = true;
+               S->textLength = 0;
+            }
+            continue;
+         }
+      }
+      while( p < complete )
+      {
+         int u, v;
+         double w;
+         int kind = parseEdgeLine(&p, complete, &u, &v, &w);
+         bool isHeader = (kind == LINE_ORDER && !S->isPastHeader);
+
+         if( kind != LINE_EMPTY )
+         {
+            S->isPastHeader = true;
+         }
+         if( kind == LINE_EDGE && u <= order && v <= order )
+         {
+            S->sources[S->buffered] = u;
+            S->targets[S->buffered] = v;
+            S->buffered++;
+            if( S->buffered == S->batchSize && !mergeBatch(S) )
+            {
+               S->textLength = end - p;
+               memmove(S->text, p, S->textLength);
+               return false;
+            }
+         }
+         else if( kind != LINE_EMPTY && !isHeader )
+         {
+            S->malformed++;
+         }
+      }
+      S->textLength = end - complete;
+      memmove(S->text, complete, S->textLength);
+   }
+   S->textLength = 0;
+   flushGraphStream(S);
+   return true;
+}
+
+// flushGraphStream()
+// Merges the buffered edges into the graph now.
+void flushGraphStream(GraphStream S)
+{
+   if( S == NULL )
+   {
+      printf("GraphStream Error: calling flushGraphStream() on NULL"
+             " GraphStream reference.\n");
+      exit(1);
+   }
+   if( S->buffered > 0 )
+   {
+      mergeBatch(S);
+   }
+}
@@ -0,0 +1,93 @@
+//-----------------------------------------------------------------------------
+// GraphStream.h
+// Header file for the GraphStream ADT, which ingests edges from a pipe or
+// any other FILE into a Graph in fixed size batches.
+//
+// Edges are read as lines of an edge list (see GraphReader.h, a weight
+// column is accepted and ignored). Memory stays bounded by the batch and a
+// small read buffer: the input is never held in full next to the graph.
+//-----------------------------------------------------------------------------
+
+#ifndef _GRAPH_STREAM_H_INCLUDE_
+#define _GRAPH_STREAM_H_INCLUDE_
+#include<stdbool.h>
+#include<stdio.h>
+#include "Graph.h"
+
+// Exported types -------------------------------------------------------------
+typedef struct GraphStreamObj* GraphStream;
+
+// BackpressureHook
+// Called after every merge. Returning false makes streamEdges() and
+// streamEdge() return false so the caller can throttle or yield before
+// reading more input.
+typedef bool (*BackpressureHook)(GraphStream S, void* context);
+
+// Constructors-Destructors ---------------------------------------------------
+
+// newGraphStream()
+// Returns a stream that adds edges (arcs if isDirected is true) to G,
+// merging them every batchSize edges.
+// Precondition: batchSize >= 1.
+GraphStream newGraphStream(Graph G, int batchSize, bool isDirected);
+
+// freeGraphStream()
+// Merges any buffered edges, then frees *pS and sets it to NULL. The graph
+// is not freed.
+void freeGraphStream(GraphStream* pS);
+
+// Access functions -----------------------------------------------------------
+
+// getStreamedEdges()
+// Returns the number of edges merged into the graph so far.
+long long getStreamedEdges(GraphStream S);
+
+// getStreamMalformed()
+// Returns the number of lines skipped because they are not edges of the
+// graph: malformed lines, lines longer than the read buffer and edges with
+// a vertex above the order of the graph.
+long long getStreamMalformed(GraphStream S);
+
+// getStreamBuffered()
+// Returns the number of edges waiting for the next merge.
+int getStreamBuffered(GraphStream S);
+
+// getStreamMerges()
+// Returns the number of merges done so far.
+int getStreamMerges(GraphStream S);
+
+// getStreamMergeSeconds()
+// Returns the total time spent merging batches into the graph.
+double getStreamMergeSeconds(GraphStream S);
+
+// getStreamRate()
+// Returns the merged edges per second since the stream was created.
+double getStreamRate(GraphStream S);
+
+// Manipulation procedures ----------------------------------------------------
+
+// setBackpressureHook()
+// Installs hook, called with context after every merge. NULL removes it.
+void setBackpressureHook(GraphStream S, BackpressureHook hook,
+                         void* context);
+
+// streamEdge()
+// Buffers one edge, merging the batch if it becomes full. Returns false if
+// that merge made the backpressure hook return false, true otherwise.
+// Precondition: u and v are between 1 and the order of the graph.
+bool streamEdge(GraphStream S, int u, int v);
+
+// streamEdges()
+// Reads edge lines from in until end of file or until the backpressure
+// hook returns false. Returns true at end of file. When the hook stops the
+// stream, the unparsed input is kept and the next call resumes from it.
+// A leading line holding only the number of vertices is skipped. Any other
+// line that is not an edge of the graph is skipped and counted by
+// getStreamMalformed(), so bad input never stops the stream.
+bool streamEdges(GraphStream S, FILE* in);
+
+// flushGraphStream()
+// Merges the buffered edges into the graph now.
+void flushGraphStream(GraphStream S);
+
+#endif
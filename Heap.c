@@ -7,6 +7,7 @@
 #include<stdio.h>
 #include<stdlib.h>
 #include "Heap.h"
+#include "MemoryUsage.h"
 #define INF -2
 #define NIL 0
 
@@ -36,6 +37,8 @@ Heap newHeap(int arrayLength, int * array)
    H->heapSize = arrayLength;
 
    H->array = (int *)malloc( (arrayLength + 1) * sizeof(int));
+   countAllocation(sizeof(HeapObj));
+   countAllocation((arrayLength + 1) * sizeof(int));
 
    H->array[0] = 0;
    for( int i = 1; i <= arrayLength; i++ )
@@ -52,6 +55,8 @@ Heap newHeap(int arrayLength, int * array)
 void freeHeap(Heap* pH){
    if(pH!=NULL && *pH!=NULL)
    {
+      countRelease((*pH)->innerArrayLength * sizeof(int));
+      countRelease(sizeof(HeapObj));
       free( (*pH)->array );
       free(*pH);
       *pH = NULL;
@@ -72,6 +77,21 @@ int getHeapSize(Heap H)
    return H->heapSize;
 }
 
+// heapMemoryUsage()
+// Returns the bytes held by H: its array and the heapObj itself.
+MemoryUsage heapMemoryUsage(Heap H)
+{
+   if( H == NULL )
+   {
+      printf("Heap Error: calling heapMemoryUsage() on NULL Heap reference.\n");
+      exit(1);
+   }
+   MemoryUsage U = newMemoryUsage();
+   U.indexBytes = sizeof(HeapObj) + H->innerArrayLength * sizeof(int);
+   U.allocations = 2;
+   return U;
+}
+
 // parent()
 // Returns the index of the parent.
 int parent(int index)
@@ -150,6 +170,7 @@ void buildHeap(Heap H)
 
 // heapSort() 
 // Sorts an input array greatest to smallest, descending order by using a heap. The zeroth entry is always zero and the array entries are shifted one step to the right.
+// The caller frees the returned array.
 // Preconditions: array length must be positive.
 int * heapSort(int * array, int length)
 {
@@ -171,7 +192,13 @@ int * heapSort(int * array, int length)
       H->heapSize--;
       heapify(H, 1);
    }
-   return H->array;
+   int * sorted = H->array;
+
+   // The array now belongs to the caller, who frees it with free().
+   countRelease(H->innerArrayLength * sizeof(int));
+   countRelease(sizeof(HeapObj));
+   free(H);
+   return sorted;
 }
 
 // Priority Queue Methods -----------------------------------------------------
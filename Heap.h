@@ -2,6 +2,7 @@
 #define _QUEUE_H_INCLUDE_
 #define INF -2
 #define NIL 0
+#include "MemoryUsage.h"
 
 // Exported type --------------------------------------------------------------
 typedef struct HeapObj* Heap;
@@ -26,6 +27,10 @@ void freeHeap(Heap* pH);
 // returns the size of the heap
 int getHeapSize(Heap H);
 
+// heapMemoryUsage()
+// Returns the bytes held by H: its array and the heapObj itself.
+MemoryUsage heapMemoryUsage(Heap H);
+
 // parent()
 // Returns the index of the parent.
 int parent(int index);
@@ -51,6 +56,7 @@ void buildHeap(Heap H);
 
 // heapSort()
 // Sorts an input array greatest to smallest by using a heap.
+// The caller frees the returned array.
 int * heapSort(int * array, int length);
 
 // priorityQueue // min priority queue
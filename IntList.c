@@ -2,10 +2,12 @@
 // Fernando Zegada
 // Implementation of the list ADT in C.
 
+#include<stdbool.h>
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
 #include "IntList.h"
+#include "MemoryUsage.h"
 
 // structs --------------------------------------------------------------------
 
@@ -20,6 +22,54 @@ typedef struct IntNodeObj
 // private IntNode type
 typedef IntNodeObj* IntNode;
 
+// private IntSlabObj type, a block of nodes that a list hands out one at a
+// time. Slabs are chained so the list can free them all at once.
+typedef struct IntSlabObj
+{
+   struct IntSlabObj* next;
+   int capacity;
+   IntNodeObj nodes[];
+} IntSlabObj;
+
+// private IntSlab type
+typedef IntSlabObj* IntSlab;
+
+// CHUNK_INTS fills a 128 byte chunk: three links, a count and the elements.
+#define CHUNK_INTS 25
+
+// private IntChunkObj type, the node of an unrolled list. It holds count
+// consecutive elements of the list in data[0..count).
+typedef struct IntChunkObj
+{
+   struct IntChunkObj* next;
+   struct IntChunkObj* previous;
+   struct IntTreeNodeObj* parent;   // NULL unless the list is sorted
+   int count;
+   int data[CHUNK_INTS];
+} IntChunkObj;
+
+// private IntChunk type
+typedef IntChunkObj* IntChunk;
+
+// TREE_FANOUT is the most children a node of the chunk tree has.
+#define TREE_FANOUT 16
+
+// private IntTreeNodeObj type, a node of the counted B+ tree that indexes
+// the chunks of a sorted list. children[i] holds counts[i] elements, the
+// smallest of which is lows[i].
+typedef struct IntTreeNodeObj
+{
+   struct IntTreeNodeObj* parent;
+   bool isAboveChunks;     // children are chunks, not tree nodes
+   int childCount;
+   void* children[TREE_FANOUT];
+   int counts[TREE_FANOUT];
+   int lows[TREE_FANOUT];
+} IntTreeNodeObj;
+
+// private IntTreeNode type
+typedef IntTreeNodeObj* IntTreeNode;
+
 // private IntListObj type
 typedef struct IntListObj
 {
@@ -28,17 +78,661 @@ typedef struct IntListObj
    IntNode cursor;         
    int length;
    int Index;           
+
+   IntSlab slabs;          // newest slab first
+   int slabUsed;           // nodes handed out from the newest slab
+   IntNode freeNodes;      // deleted nodes, chained through next
+
+   bool isUnrolled;        // elements live in chunks, not in nodes
+   IntChunk frontChunk;
+   IntChunk backChunk;
+   IntChunk cursorChunk;   // NULL when the cursor is undefined
+   int cursorOffset;
+
+   bool isSorted;          // unrolled, kept in order and indexed by root
+   IntTreeNode root;       // NULL while the list has less than two chunks
 } IntListObj;
 
+// The first slab of a list holds MIN_SLAB_NODES nodes and every new slab
+// doubles, up to MAX_SLAB_NODES, so short lists stay small and long ones
+// need few mallocs.
+#define MIN_SLAB_NODES 4
+#define MAX_SLAB_NODES 1024
+
 
 // Constructors and Destructors ------------------------------------------------
 
+// addIntSlab()
+// Gives L a new slab of capacity nodes. Private.
+void addIntSlab(IntList L, int capacity)
+{
+   size_t bytes = sizeof(IntSlabObj) + capacity * sizeof(IntNodeObj);
+   IntSlab S = malloc(bytes);
+   countAllocation(bytes);
+   S->capacity = capacity;
+   S->next = L->slabs;
+   L->slabs = S;
+   L->slabUsed = 0;
+}
+
+// freeIntSlabs()
+// Frees every slab of L, and with them every node. Private.
+void freeIntSlabs(IntList L)
+{
+   while( L->slabs != NULL )
+   {
+      IntSlab S = L->slabs;
+      L->slabs = S->next;
+      countRelease(sizeof(IntSlabObj) + S->capacity * sizeof(IntNodeObj));
+      free(S);
+   }
+   L->slabUsed = 0;
+   L->freeNodes = NULL;
+}
+
+// newIntTreeNode()
+// Returns a new childless tree node. Private.
+IntTreeNode newIntTreeNode(bool isAboveChunks)
+{
+   IntTreeNode P = malloc(sizeof(IntTreeNodeObj));
+   countAllocation(sizeof(IntTreeNodeObj));
+   P->parent = NULL;
+   P->isAboveChunks = isAboveChunks;
+   P->childCount = 0;
+   return P;
+}
+
+// freeIntTree()
+// Frees the tree node P and every tree node below it, leaving the chunks
+// without a parent. Private.
+void freeIntTree(IntTreeNode P)
+{
+   for( int i = 0; i < P->childCount; i++ )
+   {
+      if( P->isAboveChunks )
+      {
+         ((IntChunk)P->children[i])->parent = NULL;
+      }
+      else
+      {
+         freeIntTree(P->children[i]);
+      }
+   }
+   countRelease(sizeof(IntTreeNodeObj));
+   free(P);
+}
+
+// childIndex()
+// Returns the position of child among the children of P. Private.
+int childIndex(IntTreeNode P, void* child)
+{
+   int i = 0;
+   while( P->children[i] != child )
+   {
+      i++;
+   }
+   return i;
+}
+
+// adoptChild()
+// Makes P the parent of child. Private.
+void adoptChild(IntTreeNode P, void* child)
+{
+   if( P->isAboveChunks )
+   {
+      ((IntChunk)child)->parent = P;
+   }
+   else
+   {
+      ((IntTreeNode)child)->parent = P;
+   }
+}
+
+// treeCountNodes()
+// Returns the number of tree nodes in the subtree of P. Private.
+int treeCountNodes(IntTreeNode P)
+{
+   int nodes = 1;
+   for( int i = 0; !P->isAboveChunks && i < P->childCount; i++ )
+   {
+      nodes += treeCountNodes(P->children[i]);
+   }
+   return nodes;
+}
+
+// treeFixLow()
+// Copies the smallest element below P up the tree after the first child of
+// P changed. Private.
+void treeFixLow(IntTreeNode P)
+{
+   while( P->parent != NULL )
+   {
+      IntTreeNode G = P->parent;
+      int j = childIndex(G, P);
+
+      G->lows[j] = P->lows[0];
+      if( j != 0 )
+      {
+         break;
+      }
+      P = G;
+   }
+}
+
+// treeAddCount()
+// Adds delta to the count of P in every tree node above it. Private.
+void treeAddCount(IntTreeNode P, int delta)
+{
+   while( P->parent != NULL )
+   {
+      IntTreeNode G = P->parent;
+      G->counts[childIndex(G, P)] += delta;
+      P = G;
+   }
+}
+
+// treeInsert()
+// Makes child, holding count elements the smallest of which is low, the
+// i-th child of P, splitting P in half if it is full. Private.
+void treeInsert(IntList L, IntTreeNode P, int i, void* child, int count,
+                int low)
+{
+   if( P->childCount == TREE_FANOUT )
+   {
+      int half = TREE_FANOUT / 2;
+      int kept = 0;
+      int moved = 0;
+      IntTreeNode Q = newIntTreeNode(P->isAboveChunks);
+
+      Q->childCount = TREE_FANOUT - half;
+      memcpy(Q->children, P->children + half, Q->childCount * sizeof(void*));
+      memcpy(Q->counts, P->counts + half, Q->childCount * sizeof(int));
+      memcpy(Q->lows, P->lows + half, Q->childCount * sizeof(int));
+      P->childCount = half;
+      for( int k = 0; k < Q->childCount; k++ )
+      {
+         adoptChild(Q, Q->children[k]);
+         moved += Q->counts[k];
+      }
+      if( P->parent == NULL )
+      {
+         IntTreeNode R = newIntTreeNode(false);
+
+         for( int k = 0; k < half; k++ )
+         {
+            kept += P->counts[k];
+         }
+         R->childCount = 2;
+         R->children[0] = P;
+         R->children[1] = Q;
+         R->counts[0] = kept;
+         R->counts[1] = moved;
+         R->lows[0] = P->lows[0];
+         R->lows[1] = Q->lows[0];
+         P->parent = Q->parent = R;
+         L->root = R;
+      }
+      else
+      {
+         IntTreeNode G = P->parent;
+
+         treeAddCount(P, -moved);
+         treeInsert(L, G, childIndex(G, P) + 1, Q, moved, Q->lows[0]);
+      }
+      if( i > half )
+      {
+         P = Q;
+         i -= half;
+      }
+   }
+   memmove(P->children + i + 1, P->children + i,
+           (P->childCount - i) * sizeof(void*));
+   memmove(P->counts + i + 1, P->counts + i, (P->childCount - i) * sizeof(int));
+   memmove(P->lows + i + 1, P->lows + i, (P->childCount - i) * sizeof(int));
+   P->children[i] = child;
+   P->counts[i] = count;
+   P->lows[i] = low;
+   P->childCount++;
+   adoptChild(P, child);
+   treeAddCount(P, count);
+}
+
+// treeRemove()
+// Removes child, which holds no elements, from P, removing P in turn if it
+// is left without children. Private.
+void treeRemove(IntList L, IntTreeNode P, void* child)
+{
+   int i = childIndex(P, child);
+
+   P->childCount--;
+   memmove(P->children + i, P->children + i + 1,
+           (P->childCount - i) * sizeof(void*));
+   memmove(P->counts + i, P->counts + i + 1, (P->childCount - i) * sizeof(int));
+   memmove(P->lows + i, P->lows + i + 1, (P->childCount - i) * sizeof(int));
+   if( P->childCount == 0 )
+   {
+      if( P->parent == NULL )
+      {
+         L->root = NULL;
+      }
+      else
+      {
+         treeRemove(L, P->parent, P);
+      }
+      countRelease(sizeof(IntTreeNodeObj));
+      free(P);
+   }
+   else if( i == 0 )
+   {
+      treeFixLow(P);
+   }
+}
+
+// treeShrink()
+// Drops roots with a single child, and the whole tree once L is down to a
+// single chunk. Private.
+void treeShrink(IntList L)
+{
+   while( L->root != NULL && L->root->childCount == 1 )
+   {
+      IntTreeNode R = L->root;
+
+      if( R->isAboveChunks )
+      {
+         ((IntChunk)R->children[0])->parent = NULL;
+         L->root = NULL;
+      }
+      else
+      {
+         L->root = R->children[0];
+         L->root->parent = NULL;
+      }
+      countRelease(sizeof(IntTreeNodeObj));
+      free(R);
+   }
+}
+
+// syncChunk()
+// Brings the count and the smallest element of the chunk C up to date in
+// the tree above it. Private.
+void syncChunk(IntChunk C)
+{
+   IntTreeNode P = C->parent;
+   if( P == NULL )
+   {
+      return;
+   }
+   int i = childIndex(P, C);
+   int delta = C->count - P->counts[i];
+   bool isLowMoving = (C->count > 0) && (i == 0);
+
+   // A chunk that was just added holds a made up low, so the low of a first
+   // chunk goes all the way up rather than stopping where it looks current.
+   P->counts[i] = C->count;
+   if( C->count > 0 )
+   {
+      P->lows[i] = C->data[0];
+   }
+   while( P->parent != NULL && (delta != 0 || isLowMoving) )
+   {
+      IntTreeNode G = P->parent;
+      int j = childIndex(G, P);
+
+      G->counts[j] += delta;
+      if( isLowMoving )
+      {
+         G->lows[j] = P->lows[0];
+      }
+      isLowMoving = isLowMoving && (j == 0);
+      P = G;
+   }
+}
+
+// treeAddChunk()
+// Adds the new empty chunk C, already linked into L, to the tree of L,
+// building the tree when C is the second chunk. Private.
+void treeAddChunk(IntList L, IntChunk C)
+{
+   if( L->root == NULL )
+   {
+      if( L->frontChunk == L->backChunk )
+      {
+         return;
+      }
+      IntTreeNode R = newIntTreeNode(true);
+
+      for( IntChunk D = L->frontChunk; D != NULL; D = D->next )
+      {
+         R->children[R->childCount] = D;
+         R->counts[R->childCount] = D->count;
+         R->lows[R->childCount] = (D->count > 0) ? D->data[0] : 0;
+         R->childCount++;
+         D->parent = R;
+      }
+      L->root = R;
+   }
+   else if( C->previous != NULL )
+   {
+      IntTreeNode P = C->previous->parent;
+      treeInsert(L, P, childIndex(P, C->previous) + 1, C, 0, 0);
+   }
+   else
+   {
+      IntTreeNode P = C->next->parent;
+      treeInsert(L, P, childIndex(P, C->next), C, 0, 0);
+   }
+}
+
+// newIntChunk()
+// Returns a new empty chunk of L, linked after the chunk after, or at the
+// front if after is NULL. Private.
+IntChunk newIntChunk(IntList L, IntChunk after)
+{
+   IntChunk C = malloc(sizeof(IntChunkObj));
+   countAllocation(sizeof(IntChunkObj));
+   C->count = 0;
+   C->parent = NULL;
+   C->previous = after;
+   C->next = (after == NULL) ? L->frontChunk : after->next;
+   if( C->next != NULL )
+   {
+      C->next->previous = C;
+   }
+   else
+   {
+      L->backChunk = C;
+   }
+   if( after != NULL )
+   {
+      after->next = C;
+   }
+   else
+   {
+      L->frontChunk = C;
+   }
+   if( L->isSorted )
+   {
+      treeAddChunk(L, C);
+   }
+   return C;
+}
+
+// freeIntChunk()
+// Unlinks the chunk C from L and frees it. Private.
+void freeIntChunk(IntList L, IntChunk C)
+{
+   if( C->parent != NULL )
+   {
+      C->count = 0;
+      syncChunk(C);
+      treeRemove(L, C->parent, C);
+      treeShrink(L);
+   }
+   if( C->previous != NULL )
+   {
+      C->previous->next = C->next;
+   }
+   else
+   {
+      L->frontChunk = C->next;
+   }
+   if( C->next != NULL )
+   {
+      C->next->previous = C->previous;
+   }
+   else
+   {
+      L->backChunk = C->previous;
+   }
+   countRelease(sizeof(IntChunkObj));
+   free(C);
+}
+
+// chunkInsert()
+// Inserts data at offset of the chunk C of L, splitting C if it is full,
+// and keeps the cursor under the same element. Leaves length and Index to
+// the caller. Private.
+void chunkInsert(IntList L, IntChunk C, int offset, int data)
+{
+   if( C->count == CHUNK_INTS )
+   {
+      int half = CHUNK_INTS / 2;
+
+      // Growing at either end of a full chunk starts a fresh one, so lists
+      // built by appending or prepending keep their chunks full.
+      if( offset == CHUNK_INTS )
+      {
+         C = newIntChunk(L, C);
+         offset = 0;
+      }
+      else if( offset == 0 )
+      {
+         C = newIntChunk(L, C->previous);
+      }
+      else
+      {
+         IntChunk D = newIntChunk(L, C);
+
+         D->count = CHUNK_INTS - half;
+         memcpy(D->data, C->data + half, D->count * sizeof(int));
+         C->count = half;
+         syncChunk(C);
+         syncChunk(D);
+         if( L->cursorChunk == C && L->cursorOffset >= half )
+         {
+            L->cursorChunk = D;
+            L->cursorOffset -= half;
+         }
+         if( offset > half )
+         {
+            C = D;
+            offset -= half;
+         }
+      }
+   }
+   memmove(C->data + offset + 1, C->data + offset,
+           (C->count - offset) * sizeof(int));
+   C->data[offset] = data;
+   C->count++;
+   syncChunk(C);
+   if( L->cursorChunk == C && L->cursorOffset >= offset )
+   {
+      L->cursorOffset++;
+   }
+}
+
+// mergeIntChunks()
+// Moves the elements of D, the chunk after C, to the end of C and frees D.
+// Private.
+void mergeIntChunks(IntList L, IntChunk C, IntChunk D)
+{
+   memcpy(C->data + C->count, D->data, D->count * sizeof(int));
+   if( L->cursorChunk == D )
+   {
+      L->cursorChunk = C;
+      L->cursorOffset += C->count;
+   }
+   C->count += D->count;
+   syncChunk(C);
+   freeIntChunk(L, D);
+}
+
+// chunkRemove()
+// Removes the element at offset of the chunk C of L and keeps the cursor
+// under the same element; the caller undefines the cursor first if it is
+// under the removed one. C is merged with a neighbor once both fit in three
+// quarters of a chunk. Leaves length and Index to the caller. Private.
+void chunkRemove(IntList L, IntChunk C, int offset)
+{
+   memmove(C->data + offset, C->data + offset + 1,
+           (C->count - offset - 1) * sizeof(int));
+   C->count--;
+   syncChunk(C);
+   if( L->cursorChunk == C && L->cursorOffset > offset )
+   {
+      L->cursorOffset--;
+   }
+   if( C->count == 0 )
+   {
+      freeIntChunk(L, C);
+   }
+   else if( C->next != NULL
+            && C->count + C->next->count <= CHUNK_INTS * 3 / 4 )
+   {
+      mergeIntChunks(L, C, C->next);
+   }
+   else if( C->previous != NULL
+            && C->previous->count + C->count <= CHUNK_INTS * 3 / 4 )
+   {
+      mergeIntChunks(L, C->previous, C);
+   }
+}
+
+// seekIndex()
+// Returns the chunk of the unrolled list L that holds the element of index
+// i and stores its offset there in *pOffset. Private.
+IntChunk seekIndex(IntList L, int i, int* pOffset)
+{
+   IntChunk C = L->frontChunk;
+
+   if( L->root != NULL )
+   {
+      IntTreeNode P = L->root;
+      while( true )
+      {
+         int k = 0;
+         while( i >= P->counts[k] )
+         {
+            i -= P->counts[k];
+            k++;
+         }
+         if( P->isAboveChunks )
+         {
+            C = P->children[k];
+            break;
+         }
+         P = P->children[k];
+      }
+   }
+   else
+   {
+      while( i >= C->count )
+      {
+         i -= C->count;
+         C = C->next;
+      }
+   }
+   *pOffset = i;
+   return C;
+}
+
+// seekValue()
+// Finds in the sorted list L the first element that is not less than v,
+// or greater than v if isAfterEqual, or the back of L if there is none.
+// Returns its chunk, or NULL if L is empty, and stores its offset there in
+// *pOffset and its index in *pRank. The offset may be the count of the
+// chunk, meaning the front of the next one. Private.
+IntChunk seekValue(IntList L, int v, bool isAfterEqual, int* pOffset,
+                   int* pRank)
+{
+   IntChunk C = L->frontChunk;
+   int rank = 0;
+   int low = 0;
+   int high;
+
+   if( L->root != NULL )
+   {
+      IntTreeNode P = L->root;
+      while( true )
+      {
+         int k = 0;
+         while( k + 1 < P->childCount
+                && (P->lows[k + 1] < v
+                    || (isAfterEqual && P->lows[k + 1] == v)) )
+         {
+            rank += P->counts[k];
+            k++;
+         }
+         if( P->isAboveChunks )
+         {
+            C = P->children[k];
+            break;
+         }
+         P = P->children[k];
+      }
+   }
+   if( C == NULL )
+   {
+      *pOffset = *pRank = 0;
+      return NULL;
+   }
+   high = C->count;
+   while( low < high )
+   {
+      int middle = (low + high) / 2;
+      if( C->data[middle] < v || (isAfterEqual && C->data[middle] == v) )
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
+      }
+   }
+   *pOffset = low;
+   *pRank = rank + low;
+   return C;
+}
+
+// elementAt()
+// Returns the element of index i of the unrolled list L. Private.
+int elementAt(IntList L, int i)
+{
+   int offset;
+   IntChunk C = seekIndex(L, i, &offset);
+   return C->data[offset];
+}
+
+// checkOrder()
+// Exits with an error naming caller if data would break the order of the
+// sorted list L once inserted at index i. Private.
+void checkOrder(IntList L, const char* caller, int i, int data)
+{
+   if( (i > 0 && elementAt(L, i - 1) > data)
+       || (i < L->length && elementAt(L, i) < data) )
+   {
+      printf("IntList Error: calling %s() with an element out of order on a"
+             " sorted IntList.\n", caller);
+      exit(1);
+   }
+}
+
 // newIntNode()
-// Returns reference to new IntNode object. Initializes next and data fields.
+// Returns reference to new IntNode object of L, reusing a deleted node if
+// there is one. Initializes next and data fields.
 // Private.
-IntNode newIntNode(int data)
+IntNode newIntNode(IntList L, int data)
 {
-   IntNode N = malloc(sizeof(IntNodeObj));
+   IntNode N;
+
+   if( L->freeNodes != NULL )
+   {
+      N = L->freeNodes;
+      L->freeNodes = N->next;
+   }
+   else
+   {
+      if( L->slabs == NULL )
+      {
+         addIntSlab(L, MIN_SLAB_NODES);
+      }
+      else if( L->slabUsed == L->slabs->capacity )
+      {
+         int capacity = 2 * L->slabs->capacity;
+         addIntSlab(L, capacity < MAX_SLAB_NODES ? capacity : MAX_SLAB_NODES);
+      }
+      N = &(L->slabs->nodes[L->slabUsed++]);
+   }
    N->data = data;
    N->next = NULL;
    N->previous = NULL;
@@ -46,13 +740,14 @@ IntNode newIntNode(int data)
 }
 
 // freeIntNode()
-// Frees heap memory pointed to by *pN, sets *pN to NULL.
+// Returns the node *pN to the free nodes of L, sets *pN to NULL.
 // Private.
-void freeIntNode(IntNode* pN)
+void freeIntNode(IntList L, IntNode* pN)
 {
    if( pN!=NULL && *pN!=NULL )
    {
-      free(*pN);
+      (*pN)->next = L->freeNodes;
+      L->freeNodes = *pN;
       *pN = NULL;
    }
 }
@@ -63,13 +758,46 @@ IntList newIntList(void)
 {
    IntList L;
    L = malloc(sizeof(IntListObj));
+   countAllocation(sizeof(IntListObj));
    L->front = L->back = L->cursor = NULL; 
    L->length = 0;
    L->Index = -1;
+   L->slabs = NULL;
+   L->slabUsed = 0;
+   L->freeNodes = NULL;
+   L->isUnrolled = false;
+   L->frontChunk = L->backChunk = L->cursorChunk = NULL;
+   L->cursorOffset = 0;
+   L->isSorted = false;
+   L->root = NULL;
    
    return(L);
 }
 
+// newUnrolledIntList()
+// Returns reference to new empty IntList object that stores its elements
+// many to a node, so that walking it touches one cache line per dozen
+// elements. It has the same operations as any other IntList.
+IntList newUnrolledIntList(void)
+{
+   IntList L = newIntList();
+   L->isUnrolled = true;
+   return(L);
+}
+
+// newSortedIntList()
+// Returns reference to new empty unrolled IntList object that stays in
+// increasing order and keeps a tree over its chunks, so that
+// IntListInsertInOrder(), IntListContains(), IntListRank(), IntListSelect()
+// and IntListMoveTo() take O(log n) time. Inserting an element out of order
+// anywhere else is an error.
+IntList newSortedIntList(void)
+{
+   IntList L = newUnrolledIntList();
+   L->isSorted = true;
+   return(L);
+}
+
 // freeIntList()
 // Frees all heap memory associated with IntList *pL, and sets *pL to NULL.S
 void freeIntList(IntList* pL)
@@ -79,11 +807,44 @@ void freeIntList(IntList* pL)
       printf("IntList Error: calling freeIntList() on NULL list reference.\n");
       exit(1);
    }
-   clear(*pL);                                                    
+   IntListClear(*pL);
    free(*pL);
+   countRelease(sizeof(IntListObj));
    *pL = NULL;
 }
 
+// IntListReserve()
+// Makes room in L for count more elements, so that adding them takes no
+// further malloc() calls. Does nothing on an unrolled list, whose chunks
+// are allocated as they fill.
+void IntListReserve(IntList L, int count)
+{
+   if( L==NULL )
+   {
+      printf("IntList Error: calling IntListReserve() on NULL IntList"
+             " reference.\n");
+      exit(1);
+   }
+   if( L->isUnrolled )
+   {
+      return;
+   }
+   int room = (L->slabs == NULL) ? 0 : L->slabs->capacity - L->slabUsed;
+
+   if( room < count )
+   {
+      // Hand the rest of the newest slab to the free nodes so that the new
+      // slab only needs to cover the difference.
+      while( L->slabs != NULL && L->slabUsed < L->slabs->capacity )
+      {
+         IntNode N = &(L->slabs->nodes[L->slabUsed++]);
+         N->next = L->freeNodes;
+         L->freeNodes = N;
+      }
+      addIntSlab(L, count - room);
+   }
+}
+
 // Access functions -----------------------------------------------------------
 
 // IntListLength()
@@ -126,6 +887,10 @@ int IntListFront(IntList L)
       printf("IntList Error: calling IntListFront() on an empty IntList.\n");
       exit(1);
    }
+   if( L->isUnrolled )
+   {
+      return L->frontChunk->data[0];
+   }
    return(L->front->data);
 }
 
@@ -144,6 +909,10 @@ int IntListBack(IntList L)
       printf("IntList Error: calling back() on an empty IntList.\n");
       exit(1);
    }
+   if( L->isUnrolled )
+   {
+      return L->backChunk->data[L->backChunk->count - 1];
+   }
    return(L->back->data);
 }
 
@@ -161,6 +930,10 @@ int IntListGet(IntList L)
       printf("IntList Error: calling get() on undefined cursor.\n");
       exit(1);
    }
+   if( L->isUnrolled )
+   {
+      return L->cursorChunk->data[L->cursorOffset];
+   }
    return L->cursor->data; 
 }
 
@@ -169,8 +942,8 @@ int IntListGet(IntList L)
 int IntListEquals(IntList A, IntList B)
 {
    int eq = 0;
-   IntNode N = NULL;
-   IntNode M = NULL;
+   IntListIterator N;
+   IntListIterator M;
 
    if( A==NULL || B==NULL )
    {
@@ -179,21 +952,194 @@ int IntListEquals(IntList A, IntList B)
    }
 
    eq = ( A->length == B->length );
-   N = A->front;
-   M = B->front;
-   while( eq && N!=NULL)
+   N = IntListBegin(A);
+   M = IntListBegin(B);
+   while( eq && !IntListAtEnd(N) )
    {
-      eq = (N->data==M->data);
-      N = N->next;
-      M = M->next;
+      eq = ( IntListIteratorGet(N) == IntListIteratorGet(M) );
+      IntListIteratorNext(&N);
+      IntListIteratorNext(&M);
    }
    return eq;
 } 
 
+// IntListBegin()
+// Returns an iterator under the front element of L, or at the end if L is
+// empty.
+IntListIterator IntListBegin(IntList L)
+{
+   if( L==NULL )
+   {
+      printf("IntList Error: calling IntListBegin() on NULL IntList"
+             " reference.\n");
+      exit(1);
+   }
+   IntListIterator I = { L->front, L->frontChunk, 0 };
+   return I;
+}
+
+// IntListAtEnd()
+// Returns true (1) if I has gone past the back of its IntList, false (0)
+// otherwise.
+int IntListAtEnd(IntListIterator I)
+{
+   return I.node == NULL && I.chunk == NULL;
+}
+
+// IntListIteratorGet()
+// Returns the element under I.
+// Pre: !IntListAtEnd(I)
+int IntListIteratorGet(IntListIterator I)
+{
+   return (I.chunk != NULL) ? I.chunk->data[I.offset] : I.node->data;
+}
+
+// IntListIteratorNext()
+// Moves *pI to the next element of its IntList.
+// Pre: !IntListAtEnd(*pI)
+void IntListIteratorNext(IntListIterator* pI)
+{
+   if( pI->chunk != NULL )
+   {
+      if( ++(pI->offset) == pI->chunk->count )
+      {
+         pI->chunk = pI->chunk->next;
+         pI->offset = 0;
+      }
+   }
+   else
+   {
+      pI->node = pI->node->next;
+   }
+}
+
+// IntListContains()
+// Returns true (1) if v is an element of L, false (0) otherwise.
+int IntListContains(IntList L, int v)
+{
+   if( L==NULL )
+   {
+      printf("IntList Error: calling IntListContains() on NULL IntList"
+             " reference.\n");
+      exit(1);
+   }
+   if( L->isSorted )
+   {
+      int offset;
+      int rank;
+      IntChunk C = seekValue(L, v, false, &offset, &rank);
+
+      if( C != NULL && offset == C->count )
+      {
+         C = C->next;
+         offset = 0;
+      }
+      return C != NULL && C->data[offset] == v;
+   }
+   for( IntListIterator N = IntListBegin(L); !IntListAtEnd(N);
+        IntListIteratorNext(&N) )
+   {
+      if( IntListIteratorGet(N) == v )
+      {
+         return 1;
+      }
+   }
+   return 0;
+}
+
+// IntListRank()
+// Returns the number of elements of L that are less than v.
+int IntListRank(IntList L, int v)
+{
+   int rank = 0;
+
+   if( L==NULL )
+   {
+      printf("IntList Error: calling IntListRank() on NULL IntList"
+             " reference.\n");
+      exit(1);
+   }
+   if( L->isSorted )
+   {
+      int offset;
+      seekValue(L, v, false, &offset, &rank);
+      return rank;
+   }
+   for( IntListIterator N = IntListBegin(L); !IntListAtEnd(N);
+        IntListIteratorNext(&N) )
+   {
+      rank += ( IntListIteratorGet(N) < v );
+   }
+   return rank;
+}
+
+// IntListSelect()
+// Returns the element of index i of L.
+// Pre: 0 <= i < length()
+int IntListSelect(IntList L, int i)
+{
+   if( L==NULL )
+   {
+      printf("IntList Error: calling IntListSelect() on NULL IntList"
+             " reference.\n");
+      exit(1);
+   }
+   if( i < 0 || i >= IntListLength(L) )
+   {
+      printf("IntList Error: calling IntListSelect() with an index out of"
+             " bounds.\n");
+      exit(1);
+   }
+   if( L->isUnrolled )
+   {
+      return elementAt(L, i);
+   }
+   IntNode N = L->front;
+   while( i-- > 0 )
+   {
+      N = N->next;
+   }
+   return N->data;
+}
+
+// IntListMemoryUsage()
+// Returns the bytes held by L: its node slabs, including nodes that were
+// deleted and wait for reuse, or its chunks, and the list struct itself.
+MemoryUsage IntListMemoryUsage(IntList L)
+{
+   if( L==NULL )
+   {
+      printf("IntList Error: calling IntListMemoryUsage() on NULL IntList"
+             " reference.\n");
+      exit(1);
+   }
+   MemoryUsage U = newMemoryUsage();
+   U.indexBytes = sizeof(IntListObj);
+   U.allocations = 1;
+   if( L->root != NULL )
+   {
+      int treeNodes = treeCountNodes(L->root);
+      U.indexBytes += treeNodes * sizeof(IntTreeNodeObj);
+      U.allocations += treeNodes;
+   }
+   for( IntSlab S = L->slabs; S != NULL; S = S->next )
+   {
+      U.nodeBytes += sizeof(IntSlabObj) + S->capacity * sizeof(IntNodeObj);
+      U.allocations++;
+   }
+   for( IntChunk C = L->frontChunk; C != NULL; C = C->next )
+   {
+      U.nodeBytes += sizeof(IntChunkObj);
+      U.allocations++;
+   }
+   return U;
+}
+
 // Manipulation procedures ----------------------------------------------------
 
 // IntListClear()
-// Resets the list to its original empty state.
+// Resets the list to its original empty state, freeing its node slabs at
+// once.
 void IntListClear(IntList L)
 {
    if( L==NULL )
@@ -201,10 +1147,17 @@ void IntListClear(IntList L)
       printf("IntList Error: calling clear() on NULL IntList reference.\n");
       exit(1);
    }
-   while( IntListLength(L) > 0 )
-   { 
-      IntListDeleteFront(L); 
+   freeIntSlabs(L);
+   if( L->root != NULL )
+   {
+      freeIntTree(L->root);
+      L->root = NULL;
+   }
+   while( L->frontChunk != NULL )
+   {
+      freeIntChunk(L, L->frontChunk);
    }
+   L->cursorChunk = NULL;
    L->front = L->back = L->cursor = NULL; 
    L->length = 0;
    L->Index = -1; 
@@ -224,10 +1177,44 @@ void IntListMoveFront(IntList L)
    if( IntListLength(L) > 0 )
    {
       L->cursor = L->front;
+      L->cursorChunk = L->frontChunk;
+      L->cursorOffset = 0;
       L->Index = 0;
    }
 }
 
+// IntListMoveTo()
+// Places the cursor under the element of index i.
+// Pre: 0 <= i < length()
+void IntListMoveTo(IntList L, int i)
+{
+   if( L==NULL )
+   {
+      printf("IntList Error: calling IntListMoveTo() on NULL IntList"
+             " reference.\n");
+      exit(1);
+   }
+   if( i < 0 || i >= IntListLength(L) )
+   {
+      printf("IntList Error: calling IntListMoveTo() with an index out of"
+             " bounds.\n");
+      exit(1);
+   }
+   if( L->isUnrolled )
+   {
+      L->cursorChunk = seekIndex(L, i, &(L->cursorOffset));
+   }
+   else
+   {
+      L->cursor = L->front;
+      for( int k = 0; k < i; k++ )
+      {
+         L->cursor = L->cursor->next;
+      }
+   }
+   L->Index = i;
+}
+
 // IntListMoveBack()
 // If IntList is non-empty, places the cursor under the back element, otherwise
 // does nothing.
@@ -245,6 +1232,11 @@ void IntListMoveBack(IntList L)
       exit(1);
    }
    L->cursor = L->back;
+   L->cursorChunk = L->backChunk;
+   if( L->isUnrolled )
+   {
+      L->cursorOffset = L->backChunk->count - 1;
+   }
    L->Index = L->length - 1;
 }
 
@@ -260,7 +1252,23 @@ void IntListMovePrev(IntList L)
              "reference.\n");
       exit(1);
    }
-   if( IntListIndex(L) != -1 )
+   if( IntListIndex(L) != -1 && L->isUnrolled )
+   {
+      if( L->cursorOffset > 0 )
+      {
+         L->cursorOffset--;
+      }
+      else
+      {
+         L->cursorChunk = L->cursorChunk->previous;
+         if( L->cursorChunk != NULL )
+         {
+            L->cursorOffset = L->cursorChunk->count - 1;
+         }
+      }
+      L->Index = L->Index - 1;
+   }
+   else if( IntListIndex(L) != -1 )
    {
      L->cursor = L->cursor->previous; 
      L->Index = L->Index - 1;
@@ -282,8 +1290,18 @@ void IntListMoveNext(IntList L)
    if( L->Index == (L->length - 1) )
    {
       L->cursor = NULL;
+      L->cursorChunk = NULL;
       L->Index = -1;
    }
+   else if( IntListIndex(L) != -1 && L->isUnrolled )
+   {
+      if( ++(L->cursorOffset) == L->cursorChunk->count )
+      {
+         L->cursorChunk = L->cursorChunk->next;
+         L->cursorOffset = 0;
+      }
+      L->Index = L->Index + 1;
+   }
    else if( IntListIndex(L) != -1 )
    {
       L->cursor = L->cursor->next; 
@@ -302,8 +1320,26 @@ void IntListPrepend(IntList L, int data)
              " reference.\n");
       exit(1);
    }
+   if( L->isSorted )
+   {
+      checkOrder(L, "IntListPrepend", 0, data);
+   }
+   if( L->isUnrolled )
+   {
+      if( L->frontChunk == NULL )
+      {
+         newIntChunk(L, NULL);
+      }
+      chunkInsert(L, L->frontChunk, 0, data);
+      if( IntListIndex(L) > -1 )
+      {
+         (L->Index)++;
+      }
+      (L->length)++;
+      return;
+   }
 
-   IntNode nodeToPrepend = newIntNode(data);
+   IntNode nodeToPrepend = newIntNode(L, data);
    
    if( IntListLength(L) <= 0 )
    {
@@ -332,8 +1368,22 @@ void IntListAppend(IntList L, int data)
       printf("IntList Error: calling InListAppend() on NULL IntList reference.\n");
       exit(1);
    }
+   if( L->isSorted )
+   {
+      checkOrder(L, "IntListAppend", L->length, data);
+   }
+   if( L->isUnrolled )
+   {
+      if( L->backChunk == NULL )
+      {
+         newIntChunk(L, NULL);
+      }
+      chunkInsert(L, L->backChunk, L->backChunk->count, data);
+      (L->length)++;
+      return;
+   }
 
-   IntNode nodeToAppend = newIntNode(data); 
+   IntNode nodeToAppend = newIntNode(L, data); 
 
    if( IntListLength(L) <= 0)
    {
@@ -370,8 +1420,19 @@ void IntListInsertBefore(IntList L, int data)
              " cursor.\n");
       exit(1);
    }
+   if( L->isSorted )
+   {
+      checkOrder(L, "IntListInsertBefore", L->Index, data);
+   }
+   if( L->isUnrolled )
+   {
+      chunkInsert(L, L->cursorChunk, L->cursorOffset, data);
+      (L->Index)++;
+      (L->length)++;
+      return;
+   }
 
-   IntNode nodeToInsert = newIntNode(data);
+   IntNode nodeToInsert = newIntNode(L, data);
    
    if( L->cursor->previous == NULL )
    {
@@ -410,8 +1471,18 @@ void IntListInsertAfter(IntList L, int data)
       printf("IntList Error: calling insertAfter() on undefined cursor.\n");
       exit(1);
    }
+   if( L->isSorted )
+   {
+      checkOrder(L, "IntListInsertAfter", L->Index + 1, data);
+   }
+   if( L->isUnrolled )
+   {
+      chunkInsert(L, L->cursorChunk, L->cursorOffset + 1, data);
+      (L->length)++;
+      return;
+   }
 
-   IntNode nodeToInsert = newIntNode(data);
+   IntNode nodeToInsert = newIntNode(L, data);
       
    if( L->cursor->next == NULL )
    {
@@ -443,6 +1514,20 @@ void IntListDeleteFront(IntList L)
       printf("IntList Error: calling IntListDeleteFront() on empty list.\n");
       exit(1);
    }
+   if( L->isUnrolled )
+   {
+      if( IntListIndex(L) == 0 )
+      {
+         L->cursorChunk = NULL;
+      }
+      if( IntListIndex(L) != -1 )
+      {
+         (L->Index)--;
+      }
+      chunkRemove(L, L->frontChunk, 0);
+      (L->length)--;
+      return;
+   }
    if( IntListLength(L) == 1 )
    {
       if( IntListIndex(L) == 0 )
@@ -450,7 +1535,7 @@ void IntListDeleteFront(IntList L)
          L->cursor = NULL;
          L->Index = - 1;
       }
-      freeIntNode(&L->front);
+      freeIntNode(L, &L->front);
       L->back = L->front = NULL;
    }
    else
@@ -463,7 +1548,7 @@ void IntListDeleteFront(IntList L)
       }
       L->front = L->front->next;
       L->front->previous->next = NULL;
-      freeIntNode(&L->front->previous);
+      freeIntNode(L, &L->front->previous);
       L->front->previous = NULL;
    }
    (L->length)--;
@@ -483,6 +1568,17 @@ void IntListDeleteBack(IntList L)
       printf("IntList Error: calling IntListDeleteBack() on empty list.\n");
       exit(1);
    }
+   if( L->isUnrolled )
+   {
+      if( IntListIndex(L) == (IntListLength(L) - 1) )
+      {
+         L->cursorChunk = NULL;
+         L->Index = -1;
+      }
+      chunkRemove(L, L->backChunk, L->backChunk->count - 1);
+      (L->length)--;
+      return;
+   }
    if( IntListLength(L) == 1 )
    {
       if( IntListIndex(L) == 0 )
@@ -490,7 +1586,7 @@ void IntListDeleteBack(IntList L)
          L->cursor = NULL;
          L->Index = -1;
       }
-      freeIntNode(&L->front);
+      freeIntNode(L, &L->front);
       L->back = L->front = NULL;
    }
    else
@@ -502,7 +1598,7 @@ void IntListDeleteBack(IntList L)
       }
       L->back = L->back->previous;
       L->back->next->previous = NULL;
-      freeIntNode(&L->back->next);
+      freeIntNode(L, &L->back->next);
       L->back->next = NULL;
    }
    (L->length)--;
@@ -528,6 +1624,16 @@ void IntListDelete(IntList L)
       printf("IntList Error: calling IntListDelete() on undefined cursor.\n");
       exit(1);
    }
+   if( L->isUnrolled )
+   {
+      IntChunk C = L->cursorChunk;
+
+      L->cursorChunk = NULL;
+      L->Index = -1;
+      chunkRemove(L, C, L->cursorOffset);
+      (L->length)--;
+      return;
+   }
    if( IntListLength(L) == 1 )
    {
       L->front = NULL;
@@ -539,7 +1645,7 @@ void IntListDelete(IntList L)
       L->front->previous = NULL;
       L->cursor->next = NULL;
    }
-   else if( IntListIndex(L) == (length(L) - 1) )
+   else if( IntListIndex(L) == (IntListLength(L) - 1) )
    {
       L->back = L->cursor->previous;
       L->back->next = NULL;
@@ -553,7 +1659,7 @@ void IntListDelete(IntList L)
       L->cursor->previous = NULL;
    }
    L->Index = -1;
-   freeIntNode(&L->cursor);
+   freeIntNode(L, &L->cursor);
    L->cursor = NULL;
    (L->length)--;
 }
@@ -564,23 +1670,24 @@ void IntListDelete(IntList L)
 // Prints data elements in L to output file.
 void intListToString(FILE* out, IntList L)
 {
-   IntNode N = NULL;
+   IntListIterator N;
    
    if( L==NULL )
    {
       printf("IntList Error: calling listToString() on NULL IntList reference\n");
       exit(1);
    }
-   for(N = L->front; N != NULL; N = N->next)
+   for(N = IntListBegin(L); !IntListAtEnd(N); IntListIteratorNext(&N))
    {
-      fprintf(out, "%d ", N->data);
+      fprintf(out, "%d ", IntListIteratorGet(N));
    }
 }
 
 // copyIntList()
 // Returns a new list representing the same integer sequence as this IntList.
 // The cursor in the new list is undefined, regardless of the state of the
-// cursor in this IntList. This IntList is unchanged.
+// cursor in this IntList. This IntList is unchanged. The copy is of the
+// same kind as L.
 IntList copyIntList(IntList L) 
 {
    if( L==NULL )
@@ -588,23 +1695,23 @@ IntList copyIntList(IntList L)
       printf("IntList Error: calling copyIntList() on NULL IntList reference\n");
       exit(1);
    }
-   IntList listCopy = newIntList();
-   IntNode traverseIntNode = NULL;              
-   traverseIntNode = L->front;
+   IntList listCopy = L->isSorted ? newSortedIntList()
+                    : L->isUnrolled ? newUnrolledIntList() : newIntList();
+   IntListIterator traverse = IntListBegin(L);
 
-   while( traverseIntNode != NULL )
+   while( !IntListAtEnd(traverse) )
    {
-      IntListAppend(listCopy, traverseIntNode->data); 
-      traverseIntNode = traverseIntNode->next;
+      IntListAppend(listCopy, IntListIteratorGet(traverse)); 
+      IntListIteratorNext(&traverse);
    }
-   freeIntNode(&traverseIntNode);
    return listCopy;
 }
 
 
 // Helper Functions -----------------------------------------------------------
 // insertInOrder()
-// inserts new nodes in increasing order.
+// inserts new nodes in increasing order. On a sorted list this takes
+// O(log n) time and leaves the cursor under the same element.
 void IntListInsertInOrder(IntList* L, int v)
 {
    if( L == NULL || *L == NULL )
@@ -613,10 +1720,28 @@ void IntListInsertInOrder(IntList* L, int v)
              "NULL IntList reference or null pointer\n");
       exit(1);
    }
+   if( (*L)->isSorted )
+   {
+      int offset;
+      int rank;
+      IntChunk C = seekValue(*L, v, true, &offset, &rank);
+
+      if( C == NULL )
+      {
+         C = newIntChunk(*L, NULL);
+      }
+      chunkInsert(*L, C, offset, v);
+      if( (*L)->Index >= rank )
+      {
+         ((*L)->Index)++;
+      }
+      ((*L)->length)++;
+      return;
+   }
    IntListMoveFront(*L);
    while( IntListIndex(*L) != -1 )
    {
-      if( v < get(*L) )
+      if( v < IntListGet(*L) )
       {
          IntListInsertBefore(*L, v);
          break;
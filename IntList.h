@@ -4,10 +4,22 @@
 
 #ifndef _INTLIST_H_INCLUDE_
 #define _INTLIST_H_INCLUDE_
+#include "MemoryUsage.h"
 
 // Exported type --------------------------------------------------------------
 typedef struct IntListObj* IntList;
 
+// IntListIterator
+// A read position in an IntList that leaves its cursor alone, so that any
+// number of them can walk the same IntList at once, on any thread, as long
+// as nobody changes the IntList meanwhile. Its fields are private.
+typedef struct IntListIterator
+{
+   struct IntNodeObj* node;
+   struct IntChunkObj* chunk;
+   int offset;
+} IntListIterator;
+
 // Constructors-Destructors ---------------------------------------------------
 
 // newIntList()
@@ -18,6 +30,26 @@ IntList newIntList(void);
 // Frees all heap memory associated with IntList *pL, and sets *pL to NULL.
 void freeIntList(IntList* pL);
 
+// newUnrolledIntList()
+// Returns reference to new empty IntList object that stores its elements
+// many to a node, so that walking it touches one cache line per dozen
+// elements. It has the same operations as any other IntList.
+IntList newUnrolledIntList(void);
+
+// newSortedIntList()
+// Returns reference to new empty unrolled IntList object that stays in
+// increasing order and keeps a tree over its chunks, so that
+// IntListInsertInOrder(), IntListContains(), IntListRank(), IntListSelect()
+// and IntListMoveTo() take O(log n) time. Inserting an element out of order
+// anywhere else is an error.
+IntList newSortedIntList(void);
+
+// IntListReserve()
+// Makes room in L for count more elements, so that adding them takes no
+// further malloc() calls. Does nothing on an unrolled list, whose chunks
+// are allocated as they fill.
+void IntListReserve(IntList L, int count);
+
 // Access functions -----------------------------------------------------------
 
 // length()
@@ -44,10 +76,49 @@ int IntListGet(IntList L);
 // returns true (1) if A is identical to B, false (0) otherwise.
 int IntListEquals(IntList A, IntList B);
 
+// IntListBegin()
+// Returns an iterator under the front element of L, or at the end if L is
+// empty.
+IntListIterator IntListBegin(IntList L);
+
+// IntListAtEnd()
+// Returns true (1) if I has gone past the back of its IntList, false (0)
+// otherwise.
+int IntListAtEnd(IntListIterator I);
+
+// IntListIteratorGet()
+// Returns the element under I.
+// Pre: !IntListAtEnd(I)
+int IntListIteratorGet(IntListIterator I);
+
+// IntListIteratorNext()
+// Moves *pI to the next element of its IntList.
+// Pre: !IntListAtEnd(*pI)
+void IntListIteratorNext(IntListIterator* pI);
+
+// IntListContains()
+// Returns true (1) if v is an element of L, false (0) otherwise.
+int IntListContains(IntList L, int v);
+
+// IntListRank()
+// Returns the number of elements of L that are less than v.
+int IntListRank(IntList L, int v);
+
+// IntListSelect()
+// Returns the element of index i of L.
+// Pre: 0 <= i < length()
+int IntListSelect(IntList L, int i);
+
+// IntListMemoryUsage()
+// Returns the bytes held by L: its node slabs, including nodes that were
+// deleted and wait for reuse, or its chunks, and the list struct itself.
+MemoryUsage IntListMemoryUsage(IntList L);
+
 // Manipulation procedures ----------------------------------------------------
 
 // IntListClear()
-// Resets the list to its original empty state.
+// Resets the list to its original empty state, freeing its node slabs at
+// once.
 void IntListClear(IntList L);
 
 // IntListMoveFront()
@@ -55,6 +126,11 @@ void IntListClear(IntList L);
 // does nothing.
 void IntListMoveFront(IntList L);
 
+// IntListMoveTo()
+// Places the cursor under the element of index i.
+// Pre: 0 <= i < length()
+void IntListMoveTo(IntList L, int i);
+
 // IntListMoveBack()
 // If IntList is non-empty, places the cursor under the back element, otherwise
 // does nothing.
@@ -114,12 +190,14 @@ void intListToString(FILE* out, IntList L);
 // copyIntList()
 // Returns a new list representing the same integer sequence as this IntList.
 // The cursor in the new list is undefined, regardless of the state of the
-// cursor in this IntList. This IntList is unchanged.
+// cursor in this IntList. This IntList is unchanged. The copy is of the
+// same kind as L.
 IntList copyIntList(IntList L);
 
 // Helper Functions -----------------------------------------------------------
 // IntListInsertInOrder()
-// inserts new nodes in increasing order.
+// inserts new nodes in increasing order. On a sorted list this takes
+// O(log n) time and leaves the cursor under the same element.
 void IntListInsertInOrder(IntList* L, int v);
 
 
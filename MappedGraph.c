@@ -0,0 +1,448 @@
+//-----------------------------------------------------------------------------
+// MappedGraph.c
+// Implementation file for graph snapshots and the MappedGraph ADT.
+//-----------------------------------------------------------------------------
+
+#include<fcntl.h>
+#include<limits.h>
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+#include "MappedGraph.h"
+
+// structs --------------------------------------------------------------------
+
+// private MappedGraphObj type
+typedef struct MappedGraphObj
+{
+   void* mapping;
+   size_t mappingLength;
+   int order;
+   long long arcs;
+   const uint64_t* offsets;
+   const int32_t* targets;
+   const double* weights;
+} MappedGraphObj;
+
+// Snapshot functions ---------------------------------------------------------
+
+// alignSnapshot()
+// Rounds position up to the next multiple of SNAPSHOT_ALIGNMENT. Private.
+uint64_t alignSnapshot(uint64_t position)
+{
+   return (position + SNAPSHOT_ALIGNMENT - 1)
+          / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+// writeSection()
+// Pads out with zeros up to start and writes count items of size bytes.
+// Returns false on a write error. Private.
+bool writeSection(FILE* out, uint64_t* pPosition, uint64_t start,
+                  const void* items, size_t size, size_t count)
+{
+   static const char padding[SNAPSHOT_ALIGNMENT];
+
+   if( fwrite(padding, 1, start - *pPosition, out) != start - *pPosition
+       || fwrite(items, size, count, out) != count )
+   {
+      return false;
+   }
+   *pPosition = start + size * count;
+   return true;
+}
+
+// saveGraph()
+// Writes a snapshot of G to the file at path. If weights is not NULL, the
+// weight of every arc u->v is stored as getMatrixEntryData(weights, u, v),
+// the lookup relax() uses. Returns false if the file cannot be written.
+bool saveGraph(const char* path, Graph G, Matrix weights)
+{
+   if( G == NULL || path == NULL )
+   {
+      printf("MappedGraph Error: calling saveGraph() on NULL Graph or path"
+             " reference.\n");
+      exit(1);
+   }
+   int n = getGraphOrder(G);
+   long long* offsets;
+   int* targets;
+   uint64_t* wideOffsets = malloc((n + 2) * sizeof(uint64_t));
+   double* arcWeights = NULL;
+   SnapshotHeader header;
+   uint64_t position = 0;
+   bool isWritten;
+   FILE* out;
+
+   buildWideAdjacencyArrays(G, &offsets, &targets);
+   for( int u = 0; u <= n + 1; u++ )
+   {
+      wideOffsets[u] = offsets[u];
+   }
+   if( weights != NULL )
+   {
+      int* arcSources = malloc((offsets[n + 1] + 1) * sizeof(int));
+
+      arcWeights = malloc((offsets[n + 1] + 1) * sizeof(double));
+      for( int u = 1; u <= n; u++ )
+      {
+         for( long long e = offsets[u]; e < offsets[u + 1]; e++ )
+         {
+            arcSources[e] = u;
+         }
+      }
+      // getEntries() takes an int count, so look the weights up in chunks.
+      for( long long first = 0; first < offsets[n + 1]; first += INT_MAX )
+      {
+         long long count = offsets[n + 1] - first;
+         getEntries(weights, targets + first, arcSources + first,
+                    arcWeights + first, (count < INT_MAX) ? count : INT_MAX);
+      }
+      free(arcSources);
+   }
+
+   memset(&header, 0, sizeof(header));
+   memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+   header.version = SNAPSHOT_VERSION;
+   header.byteOrder = SNAPSHOT_BYTE_ORDER;
+   header.flags = (weights != NULL) ? SNAPSHOT_HAS_WEIGHTS : 0;
+   header.order = n;
+   header.arcs = offsets[n + 1];
+   header.offsetsStart = alignSnapshot(sizeof(header));
+   header.targetsStart = alignSnapshot(header.offsetsStart
+                                       + (n + 2) * sizeof(uint64_t));
+   header.fileSize = header.targetsStart + header.arcs * sizeof(int32_t);
+   if( weights != NULL )
+   {
+      header.weightsStart = alignSnapshot(header.fileSize);
+      header.fileSize = header.weightsStart + header.arcs * sizeof(double);
+   }
+
+   out = fopen(path, "wb");
+   isWritten = (out != NULL)
+      && writeSection(out, &position, 0, &header, sizeof(header), 1)
+      && writeSection(out, &position, header.offsetsStart, wideOffsets,
+                      sizeof(uint64_t), n + 2)
+      && writeSection(out, &position, header.targetsStart, targets,
+                      sizeof(int32_t), header.arcs)
+      && ( weights == NULL
+           || writeSection(out, &position, header.weightsStart, arcWeights,
+                           sizeof(double), header.arcs) );
+   if( out != NULL && fclose(out) != 0 )
+   {
+      isWritten = false;
+   }
+
+   free(offsets);
+   free(targets);
+   free(wideOffsets);
+   free(arcWeights);
+   return isWritten;
+}
+
+// isSectionInside()
+// Returns true if count items of size bytes starting at start are aligned
+// and fit in a file of fileSize bytes. Private.
+bool isSectionInside(uint64_t start, uint64_t count, uint64_t size,
+                     uint64_t fileSize)
+{
+   return start % SNAPSHOT_ALIGNMENT == 0 && start >= sizeof(SnapshotHeader)
+          && start <= fileSize && count <= (fileSize - start) / size;
+}
+
+// isSnapshotValid()
+// Returns true if the header of the mapped snapshot matches this version,
+// byte order and fileSize, every section lies inside the file, and the
+// offsets never decrease and end at arcs. Reads the header and the offsets
+// only, so it takes O(order) time however many arcs there are. Private.
+bool isSnapshotValid(const void* mapping, uint64_t fileSize)
+{
+   const SnapshotHeader* header = mapping;
+   const uint64_t* offsets;
+   bool hasWeights = (header->flags & SNAPSHOT_HAS_WEIGHTS) != 0;
+
+   if( memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0
+       || header->version != SNAPSHOT_VERSION
+       || header->byteOrder != SNAPSHOT_BYTE_ORDER
+       || header->fileSize != fileSize
+       || header->order < 0 || header->order == INT32_MAX
+       || !isSectionInside(header->offsetsStart, (uint64_t)header->order + 2,
+                           sizeof(uint64_t), fileSize)
+       || !isSectionInside(header->targetsStart, header->arcs,
+                           sizeof(int32_t), fileSize)
+       || ( hasWeights
+            && !isSectionInside(header->weightsStart, header->arcs,
+                                sizeof(double), fileSize) )
+       || ( !hasWeights && header->weightsStart != 0 ) )
+   {
+      return false;
+   }
+
+   offsets = (const uint64_t*)((const char*)mapping + header->offsetsStart);
+   for( int u = 1; u <= header->order; u++ )
+   {
+      if( offsets[u] > offsets[u + 1] )
+      {
+         return false;
+      }
+   }
+   return offsets[header->order + 1] == header->arcs;
+}
+
+// mmapGraph()
+// Maps the snapshot at path read-only and returns a MappedGraph reading it
+// in place, or NULL if the file cannot be mapped or is not a well formed
+// snapshot of this version and byte order. Checks the header and the
+// offsets but not the targets, so it never reads the arcs; check a file
+// from an untrusted source with validateSnapshot(). Processes mapping the
+// same file share one copy of it in the page cache.
+MappedGraph mmapGraph(const char* path)
+{
+   if( path == NULL )
+   {
+      printf("MappedGraph Error: calling mmapGraph() on NULL path.\n");
+      exit(1);
+   }
+   struct stat status;
+   const SnapshotHeader* header;
+   void* mapping;
+   MappedGraph M;
+   int descriptor = open(path, O_RDONLY);
+
+   if( descriptor < 0 )
+   {
+      return NULL;
+   }
+   if( fstat(descriptor, &status) != 0
+       || (size_t)status.st_size < sizeof(SnapshotHeader) )
+   {
+      close(descriptor);
+      return NULL;
+   }
+   mapping = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+   close(descriptor);
+   if( mapping == MAP_FAILED )
+   {
+      return NULL;
+   }
+
+   header = mapping;
+   if( !isSnapshotValid(mapping, status.st_size) )
+   {
+      munmap(mapping, status.st_size);
+      return NULL;
+   }
+
+   M = malloc(sizeof(MappedGraphObj));
+   M->mapping = mapping;
+   M->mappingLength = status.st_size;
+   M->order = header->order;
+   M->arcs = header->arcs;
+   M->offsets = (const uint64_t*)((const char*)mapping + header->offsetsStart);
+   M->targets = (const int32_t*)((const char*)mapping + header->targetsStart);
+   M->weights = NULL;
+   if( header->flags & SNAPSHOT_HAS_WEIGHTS )
+   {
+      M->weights = (const double*)((const char*)mapping
+                                   + header->weightsStart);
+   }
+   return M;
+}
+
+// unmapGraph()
+// Unmaps the snapshot and frees *pM, setting *pM to NULL.
+void unmapGraph(MappedGraph* pM)
+{
+   if( pM != NULL && *pM != NULL )
+   {
+      munmap((*pM)->mapping, (*pM)->mappingLength);
+      free(*pM);
+      *pM = NULL;
+   }
+}
+
+// validateSnapshot()
+// Returns true if every target of M is a vertex and every adjacency list is
+// sorted. Reads all the arcs, so run it once on a snapshot
+// from an untrusted source rather than on every load.
+bool validateSnapshot(MappedGraph M)
+{
+   if( M == NULL )
+   {
+      printf("MappedGraph Error: calling validateSnapshot() on NULL"
+             " MappedGraph reference.\n");
+      exit(1);
+   }
+   for( int u = 1; u <= M->order; u++ )
+   {
+      int previous = 1;
+
+      for( uint64_t e = M->offsets[u]; e < M->offsets[u + 1]; e++ )
+      {
+         if( M->targets[e] < previous || M->targets[e] > M->order )
+         {
+            return false;
+         }
+         previous = M->targets[e];
+      }
+   }
+   return true;
+}
+
+// Access functions -----------------------------------------------------------
+
+// getMappedOrder()
+// Returns the number of vertices.
+int getMappedOrder(MappedGraph M)
+{
+   if( M == NULL )
+   {
+      printf("MappedGraph Error: calling getMappedOrder() on NULL"
+             " MappedGraph reference.\n");
+      exit(1);
+   }
+   return M->order;
+}
+
+// getMappedArcs()
+// Returns the number of stored adjacency entries (an edge added with
+// addEdge() is stored twice).
+long long getMappedArcs(MappedGraph M)
+{
+   if( M == NULL )
+   {
+      printf("MappedGraph Error: calling getMappedArcs() on NULL"
+             " MappedGraph reference.\n");
+      exit(1);
+   }
+   return M->arcs;
+}
+
+// hasMappedWeights()
+// Returns true if the snapshot stores arc weights.
+bool hasMappedWeights(MappedGraph M)
+{
+   if( M == NULL )
+   {
+      printf("MappedGraph Error: calling hasMappedWeights() on NULL"
+             " MappedGraph reference.\n");
+      exit(1);
+   }
+   return M->weights != NULL;
+}
+
+// getMappedDegree()
+// Returns the length of the adjacency list of u.
+// Precondition: 1 <= u <= getMappedOrder(M).
+int getMappedDegree(MappedGraph M, int u)
+{
+   if( M == NULL )
+   {
+      printf("MappedGraph Error: calling getMappedDegree() on NULL"
+             " MappedGraph reference.\n");
+      exit(1);
+   }
+   if( u < 1 || u > M->order )
+   {
+      printf("MappedGraph Error: calling getMappedDegree() for an out of"
+             " bounds vertex.\n");
+      exit(1);
+   }
+   return (int)(M->offsets[u + 1] - M->offsets[u]);
+}
+
+// getMappedNeighbors()
+// Returns a pointer into the mapping to the getMappedDegree(M, u) neighbors
+// of u, in increasing order.
+// Precondition: 1 <= u <= getMappedOrder(M).
+const int32_t* getMappedNeighbors(MappedGraph M, int u)
+{
+   if( M == NULL )
+   {
+      printf("MappedGraph Error: calling getMappedNeighbors() on NULL"
+             " MappedGraph reference.\n");
+      exit(1);
+   }
+   if( u < 1 || u > M->order )
+   {
+      printf("MappedGraph Error: calling getMappedNeighbors() for an out of"
+             " bounds vertex.\n");
+      exit(1);
+   }
+   return M->targets + M->offsets[u];
+}
+
+// getMappedWeights()
+// Returns a pointer into the mapping to the weights of the arcs leaving u,
+// parallel to getMappedNeighbors(), or NULL if there are no weights.
+// Precondition: 1 <= u <= getMappedOrder(M).
+const double* getMappedWeights(MappedGraph M, int u)
+{
+   if( M == NULL )
+   {
+      printf("MappedGraph Error: calling getMappedWeights() on NULL"
+             " MappedGraph reference.\n");
+      exit(1);
+   }
+   if( u < 1 || u > M->order )
+   {
+      printf("MappedGraph Error: calling getMappedWeights() for an out of"
+             " bounds vertex.\n");
+      exit(1);
+   }
+   if( M->weights == NULL )
+   {
+      return NULL;
+   }
+   return M->weights + M->offsets[u];
+}
+
+// Algorithms -----------------------------------------------------------------
+
+// mappedBFS()
+// Runs breadth first search from s. Stores in distance[1..n] and
+// parents[1..n] the same values that getDist() and getParent() report after
+// BFS() on the saved Graph.
+// Precondition: 1 <= s <= getMappedOrder(M).
+void mappedBFS(MappedGraph M, int s, int* distance, int* parents)
+{
+   if( M == NULL || distance == NULL || parents == NULL )
+   {
+      printf("MappedGraph Error: calling mappedBFS() on NULL reference.\n");
+      exit(1);
+   }
+   if( s < 1 || s > M->order )
+   {
+      printf("MappedGraph Error: calling mappedBFS() with an out of bounds"
+             " source.\n");
+      exit(1);
+   }
+   int* queue = malloc(M->order * sizeof(int));
+   int head = 0, tail = 0;
+
+   for( int i = 1; i <= M->order; i++ )
+   {
+      distance[i] = INF;
+      parents[i] = NIL;
+   }
+   distance[s] = 0;
+   queue[tail++] = s;
+
+   while( head < tail )
+   {
+      int u = queue[head++];
+      for( uint64_t e = M->offsets[u]; e < M->offsets[u + 1]; e++ )
+      {
+         int v = M->targets[e];
+         if( distance[v] == INF )
+         {
+            distance[v] = distance[u] + 1;
+            parents[v] = u;
+            queue[tail++] = v;
+         }
+      }
+   }
+   free(queue);
+}
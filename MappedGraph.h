@@ -0,0 +1,116 @@
+//-----------------------------------------------------------------------------
+// MappedGraph.h
+// Header file for the binary graph snapshot format and the MappedGraph ADT,
+// a read-only graph that traverses a snapshot file mapped into memory.
+//
+// A snapshot is laid out as follows, every section starting on a 64 byte
+// boundary and all numbers in the byte order of the machine that saved it:
+//
+//    header   SnapshotHeader
+//    offsets  uint64_t[order + 2], neighbors of u are targets[offsets[u]]
+//             up to but not including targets[offsets[u + 1]]
+//    targets  int32_t[arcs], every list in increasing order
+//    weights  double[arcs], only if the header has SNAPSHOT_HAS_WEIGHTS
+//-----------------------------------------------------------------------------
+
+#ifndef _MAPPED_GRAPH_H_INCLUDE_
+#define _MAPPED_GRAPH_H_INCLUDE_
+#include<stdbool.h>
+#include<stdint.h>
+#include "Graph.h"
+#include "Matrix.h"
+
+#define SNAPSHOT_MAGIC "GRAPHSNP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_ALIGNMENT 64
+#define SNAPSHOT_HAS_WEIGHTS 1
+
+// Exported types -------------------------------------------------------------
+typedef struct MappedGraphObj* MappedGraph;
+
+// SnapshotHeader
+// The first 64 bytes of a snapshot file.
+typedef struct SnapshotHeader
+{
+   char magic[8];
+   uint32_t version;
+   uint32_t byteOrder;
+   uint32_t flags;
+   int32_t order;
+   uint64_t arcs;
+   uint64_t offsetsStart;
+   uint64_t targetsStart;
+   uint64_t weightsStart;
+   uint64_t fileSize;
+} SnapshotHeader;
+
+// Snapshot functions ---------------------------------------------------------
+
+// saveGraph()
+// Writes a snapshot of G to the file at path. If weights is not NULL, the
+// weight of every arc u->v is stored as getMatrixEntryData(weights, u, v),
+// the lookup relax() uses. Returns false if the file cannot be written.
+bool saveGraph(const char* path, Graph G, Matrix weights);
+
+// mmapGraph()
+// Maps the snapshot at path read-only and returns a MappedGraph reading it
+// in place, or NULL if the file cannot be mapped or is not a well formed
+// snapshot of this version and byte order. Checks the header and the
+// offsets but not the targets, so it never reads the arcs; check a file
+// from an untrusted source with validateSnapshot(). Processes mapping the
+// same file share one copy of it in the page cache.
+MappedGraph mmapGraph(const char* path);
+
+// unmapGraph()
+// Unmaps the snapshot and frees *pM, setting *pM to NULL.
+void unmapGraph(MappedGraph* pM);
+
+// validateSnapshot()
+// Returns true if every target of M is a vertex and every adjacency list is
+// sorted. Reads all the arcs, so run it once on a snapshot
+// from an untrusted source rather than on every load.
+bool validateSnapshot(MappedGraph M);
+
+// Access functions -----------------------------------------------------------
+
+// getMappedOrder()
+// Returns the number of vertices.
+int getMappedOrder(MappedGraph M);
+
+// getMappedArcs()
+// Returns the number of stored adjacency entries (an edge added with
+// addEdge() is stored twice).
+long long getMappedArcs(MappedGraph M);
+
+// hasMappedWeights()
+// Returns true if the snapshot stores arc weights.
+bool hasMappedWeights(MappedGraph M);
+
+// getMappedDegree()
+// Returns the length of the adjacency list of u.
+// Precondition: 1 <= u <= getMappedOrder(M).
+int getMappedDegree(MappedGraph M, int u);
+
+// getMappedNeighbors()
+// Returns a pointer into the mapping to the getMappedDegree(M, u) neighbors
+// of u, in increasing order.
+// Precondition: 1 <= u <= getMappedOrder(M).
+const int32_t* getMappedNeighbors(MappedGraph M, int u);
+
+// getMappedWeights()
+// Returns a pointer into the mapping to the weights of the arcs leaving u,
+// parallel to getMappedNeighbors(), or NULL if there are no weights.
+// Precondition: 1 <= u <= getMappedOrder(M).
+const double* getMappedWeights(MappedGraph M, int u);
+
+// Algorithms -----------------------------------------------------------------
+
+// mappedBFS()
+// Runs breadth first search from s. Stores in distance[1..n] and
+// parents[1..n] the same values that getDist() and getParent() report after
+// BFS() on the saved Graph.
+// Precondition: 1 <= s <= getMappedOrder(M).
+void mappedBFS(MappedGraph M, int s, int* distance, int* parents);
+
+#endif
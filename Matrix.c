@@ -2,23 +2,24 @@
 // Fernando Zegada
 // Matrix implements a linear algebra matrix with its addition, multiplication
 // defined for square matrices. The particular implementation is for sparse
-// matrices using arrays of lists.
+// matrices using arrays of lists, or compressed sparse row arrays.
 
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+#include "BufferedWriter.h"
 #include "Matrix.h"
 #include "EntryList.h"
+#include "MemoryUsage.h"
 
-// Entry struct -------------------------------------------------------------------
-
-typedef struct EntryObj
-{
-   double data;
-   int columnNumber; 
-} EntryObj;
-      
 // Constructors and destructors ---------------------------------------------------
 
 // newEntry()
@@ -27,6 +28,7 @@ Entry newEntry(int columnNumber, double data)
 {
    Entry E;
    E = malloc(sizeof(EntryObj));
+   countAllocation(sizeof(EntryObj));
    E->data = data;
    E->columnNumber = columnNumber;
    return E;
@@ -43,11 +45,24 @@ Entry copyEntry(Entry other)
       exit(1);
    }
    Entry E = malloc(sizeof(EntryObj));
+   countAllocation(sizeof(EntryObj));
    E->data = other->data;
    E->columnNumber = other->columnNumber;
    return E;
 }
 
+// freeEntry()
+// Frees an entry made by newEntry() or copyEntry(), sets *pE to NULL.
+void freeEntry(Entry* pE)
+{
+   if( pE != NULL && *pE != NULL )
+   {
+      free(*pE);
+      countRelease(sizeof(EntryObj));
+      *pE = NULL;
+   }
+}
+
 // getEntryColumn()
 // returns the column field in an entry struct.
 int getEntryColumn(Entry E)
@@ -116,9 +131,34 @@ bool areEntriesEqual(Entry L, Entry R)
 typedef struct MatrixObj
 {
    int dimensions;
-   List* rows;
+   List* rows;             // NULL while compressed
+
+   // Compressed sparse row form: row i holds columns[k], values[k] for
+   // rowStart[i] <= k < rowStart[i + 1], in increasing column order.
+   bool isCompressed;
+   int* rowStart;
+   int* columns;
+   double* values;
+
+   struct EntryHashObj* hash;  // the long rows, or NULL until hashMatrix()
+   struct MatrixObj* transposed;  // kept by spmvT(), or NULL
 } MatrixObj;
 
+// Rows holding at least this many entries go in the table hashMatrix()
+// builds. Shorter rows are quicker to search directly.
+#define HASHED_ROW_LENGTH 32
+
+// EntryHashObj
+// An open addressing table of the entries in the long rows of a Matrix,
+// keyed by row and column. Private.
+typedef struct EntryHashObj
+{
+   int capacity;           // a power of two
+   int* rows;              // 0 marks an empty slot
+   int* columns;
+   double* values;
+} EntryHashObj;
+
 // Contructors --------------------------------------------------------------------
 
 // newMatrix()
@@ -134,7 +174,14 @@ Matrix newMatrix(int n)
    Matrix M;
    M = malloc(sizeof(MatrixObj));
    M->dimensions = n;
+   M->isCompressed = false;
+   M->rowStart = M->columns = NULL;
+   M->values = NULL;
+   M->hash = NULL;
+   M->transposed = NULL;
    M->rows = (List *)malloc( (n + 1) * sizeof(List) );
+   countAllocation(sizeof(MatrixObj));
+   countAllocation((n + 1) * sizeof(List));
 
    for( int i = 0; i <= M->dimensions; i++) // <= because I am ignoring index 0
    {
@@ -143,6 +190,82 @@ Matrix newMatrix(int n)
    return M;
 }
 
+// newCompressedMatrix()
+// Returns a compressed n by n Matrix with room for nnz entries, whose
+// rowStart is all zeros. Private.
+Matrix newCompressedMatrix(int n, int nnz)
+{
+   Matrix M = malloc(sizeof(MatrixObj));
+   M->dimensions = n;
+   M->rows = NULL;
+   M->isCompressed = true;
+   M->hash = NULL;
+   M->transposed = NULL;
+   M->rowStart = calloc(n + 2, sizeof(int));
+   M->columns = malloc((nnz + 1) * sizeof(int));
+   M->values = malloc((nnz + 1) * sizeof(double));
+   countAllocation(sizeof(MatrixObj));
+   countAllocation((n + 2) * sizeof(int));
+   countAllocation((nnz + 1) * (sizeof(int) + sizeof(double)));
+   return M;
+}
+
+// freeRowArrays()
+// Frees the compressed arrays of M. Private.
+void freeRowArrays(Matrix M)
+{
+   int nnz = M->rowStart[M->dimensions + 1];
+
+   countRelease((M->dimensions + 2) * sizeof(int));
+   countRelease((nnz + 1) * (sizeof(int) + sizeof(double)));
+   free(M->rowStart);
+   free(M->columns);
+   free(M->values);
+   M->rowStart = M->columns = NULL;
+   M->values = NULL;
+}
+
+// freeRowLists()
+// Frees the row lists of M and the array that holds them. Private.
+void freeRowLists(Matrix M)
+{
+   for( int i = 0; i <= M->dimensions; i++)
+   {
+      freeList( &(M->rows[i]) );
+   }
+   countRelease((M->dimensions + 1) * sizeof(List));
+   free(M->rows);
+   M->rows = NULL;
+}
+
+// freeEntryHash()
+// Frees the table built by hashMatrix(), if M has one. Private.
+void freeEntryHash(Matrix M)
+{
+   EntryHashObj* H = M->hash;
+
+   if( H != NULL )
+   {
+      countRelease(sizeof(EntryHashObj));
+      countRelease(H->capacity * (2 * sizeof(int) + sizeof(double)));
+      free(H->rows);
+      free(H->columns);
+      free(H->values);
+      free(H);
+      M->hash = NULL;
+   }
+}
+
+// freeTransposed()
+// Frees the transpose kept by spmvT(), if M has one. Private.
+void freeTransposed(Matrix M)
+{
+   if( M->transposed != NULL )
+   {
+      freeMatrix(&(M->transposed));
+   }
+}
+
 // freeMatrix()
 // free each list that represents a row and finally frees the memory of
 // the matrixObj itsef
@@ -150,34 +273,46 @@ void freeMatrix(Matrix* pM)
 {
    if(pM!=NULL && *pM!=NULL)
    {
-      for( int i = 0; i <= (*pM)->dimensions; i++)
+      if( (*pM)->isCompressed )
+      {
+         freeRowArrays(*pM);
+      }
+      else
       {
-         freeList( &( (*pM)->rows[i] ) );
+         freeRowLists(*pM);
       }
+      freeEntryHash(*pM);
+      freeTransposed(*pM);
+      countRelease(sizeof(MatrixObj));
       free(*pM);
       *pM = NULL;
    }
 }
 
 // copyMatrix()
-// Deep-copies a matrix.
+// Deep-copies a matrix, keeping its storage mode.
 Matrix copyMatrix(Matrix M)
 {
+   if( M->isCompressed )
+   {
+      int n = M->dimensions;
+      int nnz = M->rowStart[n + 1];
+      Matrix matrixCopy = newCompressedMatrix(n, nnz);
+
+      memcpy(matrixCopy->rowStart, M->rowStart, (n + 2) * sizeof(int));
+      memcpy(matrixCopy->columns, M->columns, nnz * sizeof(int));
+      memcpy(matrixCopy->values, M->values, nnz * sizeof(double));
+      return matrixCopy;
+   }
    Matrix matrixCopy = newMatrix(M->dimensions);
-   List thisRow = newList();
- 
-   int thisColumn;
-   double thisData;
 
    for( int i = 1; i <= M->dimensions; i++ )
    {
-      thisRow = M->rows[i];
-  
-      for( moveFront(thisRow); Index(thisRow)!= -1; moveNext(thisRow) )
+      for( ListIterator I = listBegin(M->rows[i]); !listAtEnd(I);
+           iteratorNext(&I) )
       {
-         thisColumn = getEntryColumn(get(thisRow));
-         thisData = getEntryData(get(thisRow));
-         changeEntry(matrixCopy, i, thisColumn, thisData);
+         appendEntry(matrixCopy->rows[i], iteratorColumn(I),
+                     iteratorData(I));
       }
    }
    return matrixCopy;
@@ -197,6 +332,10 @@ int getMatrixSize(Matrix M)
 int getNNZ(Matrix M)
 {
    int counter = 0;
+   if( M->isCompressed )
+   {
+      return M->rowStart[M->dimensions + 1];
+   }
    for( int i = 1; i <= M->dimensions; i++ )
    {
       counter += length(M->rows[i]);
@@ -208,8 +347,8 @@ int getNNZ(Matrix M)
 // Returns true if two matrices are equal. False otherwise.
 bool areMatricesEqual(Matrix L, Matrix R)
 {
-   List left = newList();
-   List right = newList();
+   RowIterator left;
+   RowIterator right;
 
    if(  L ==  R )
    {
@@ -221,437 +360,3675 @@ bool areMatricesEqual(Matrix L, Matrix R)
    }
    for( int i = 1; i <= L->dimensions; i++ )
    {
-      left = L->rows[i];
-      right = R->rows[i];
-
-      if( length(left) != length(right))
-      {
-          return false;
-      }
-      moveFront(left);
-      moveFront(right);
+      left = rowBegin(L, i);
+      right = rowBegin(R, i);
 
-      while( Index(left) != -1 )
+      while( !rowAtEnd(left) && !rowAtEnd(right) )
       {
-         if( !( areEntriesEqual(get(left), get(right)) ) )
+         if( rowColumn(left) != rowColumn(right)
+             || rowData(left) != rowData(right) )
          {
             return false;
          }
-         moveNext(left);
-         moveNext(right);
+         rowNext(&left);
+         rowNext(&right);
+      }
+      if( !rowAtEnd(left) || !rowAtEnd(right) )
+      {
+         return false;
       }
    }
    return true;
 }
 
-double getMatrixEntryData(Matrix M, int column, int row)
+// rowLength()
+// Returns the number of entries in row i of M. Private.
+int rowLength(Matrix M, int i)
+{
+   if( M->isCompressed )
+   {
+      return M->rowStart[i + 1] - M->rowStart[i];
+   }
+   return length(M->rows[i]);
+}
+
+// hashSlot()
+// Returns the first slot of a table of mask + 1 slots to probe for the
+// entry at row, column. Private.
+unsigned hashSlot(int row, int column, unsigned mask)
+{
+   unsigned h = (unsigned)row * 2654435761u ^ (unsigned)column * 2246822519u;
+   return (h ^ (h >> 15)) & mask;
+}
+
+// isRowHashed()
+// Returns true if row i of M is in the table built by hashMatrix().
+// Private.
+bool isRowHashed(Matrix M, int i)
 {
-   List * workingList = &( M->rows[row] );
-   Entry workingEntry = newEntry(0, 0.0);
+   return M->hash != NULL && rowLength(M, i) >= HASHED_ROW_LENGTH;
+}
+
+// hashedEntryData()
+// Returns the value at row, column of a Matrix whose row is hashed, or 0.0
+// if there is no entry there. Private.
+double hashedEntryData(Matrix M, int row, int column)
+{
+   EntryHashObj* H = M->hash;
+   unsigned mask = H->capacity - 1;
+   unsigned slot = hashSlot(row, column, mask);
 
-   for
-   ( moveFront(*workingList);
-     Index(*workingList) != -1;
-     moveNext(*workingList)
-   ){
-      workingEntry =  get(*workingList);
-      if( getEntryColumn(workingEntry) == column )
+   while( H->rows[slot] != 0 )
+   {
+      if( H->rows[slot] == row && H->columns[slot] == column )
       {
-	 return getEntryData(workingEntry);
+         return H->values[slot];
       }
+      slot = (slot + 1) & mask;
    }
-   return 0.0; // clearly an error has ocurred. maybe should return a
-               // ridiculous value and test for it somewhere in the client.
+   return 0.0;
 }
 
-// Manipulation procedures -------------------------------------------------
-
-// makeZero()
-// Puts the matrix back to its initial condition wehere there are no non-zero
-// entries.
-void makeZero(Matrix M)
+// findCompressedEntry()
+// Returns the index in the arrays of the compressed M of the entry at row,
+// column, found by bisection, or -1 if there is none. Private.
+int findCompressedEntry(Matrix M, int row, int column)
 {
-   for( int i = 1; i <= M->dimensions; i++ )
+   int low = M->rowStart[row], high = M->rowStart[row + 1];
+
+   while( low < high )
    {
-      clear(M->rows[i]);
+      int middle = (low + high) / 2;
+      if( M->columns[middle] < column )
+      {
+         low = middle + 1;
+      }
+      else
+      {
+         high = middle;
+      }
+   }
+   if( low < M->rowStart[row + 1] && M->columns[low] == column )
+   {
+      return low;
    }
+   return -1;
 }
 
-// changeEntry()
-// pre: 1<=i<=getMatrixSize(), 1<=j<=getMatrixSize()
-// changes ith row, jth column of this Matrix to x
-void changeEntry(Matrix M, int i, int j, double x)
+// getMatrixEntryData()
+// returns the data in an Entry when given column and row as arguments, or
+// 0.0 if there is none. Searches a compressed row by bisection, a row kept
+// as a List from the front, and a row in the table of hashMatrix() by
+// hashing.
+double getMatrixEntryData(Matrix M, int column, int row)
 {
-   if( i < 1 || i > getMatrixSize(M) || j < 1 || j > getMatrixSize(M) )
+   if( isRowHashed(M, row) )
    {
-      printf( "Error: Program: Sparse, module: Matrix, precondition:"
-              " changeEntry() called with out of bounds arguments.");
-      exit(1);
+      return hashedEntryData(M, row, column);
    }
-   Entry E = newEntry(j, x);
-   if( length(M->rows[i]) != 0.0 )
+   if( M->isCompressed )
    {
-      for( moveFront(M->rows[i]); Index(M->rows[i]) != -1; moveNext(M->rows[i]) )
+      int k = findCompressedEntry(M, row, column);
+      return (k >= 0) ? M->values[k] : 0.0;
+   }
+   for( ListIterator I = listBegin(M->rows[row]); !listAtEnd(I);
+        iteratorNext(&I) )
+   {
+      if( iteratorColumn(I) == column )
       {
-         if( getEntryColumn(get(M->rows[i])) == j )
-         {
-            if( x == 0.0 )
-            {
-               delete(M->rows[i]);
-            }
-            else
-            {
-               setData( get( M->rows[i] ), x ); 
-            }
-            break;
-         }
-         if(  getEntryColumn( get(M->rows[i]) )  > j ) 
-         {
-            if( x != 0.0 )
-            {
-               insertBefore(M->rows[i], E);
-            }
-            break;
-         }
+	 return iteratorData(I);
+      }
+      if( iteratorColumn(I) > column ) // rows are sorted by column
+      {
+         break;
       }
    }
-   if( Index(M->rows[i]) == -1 && x != 0 )
+   return 0.0;
+}
+
+// Query type. Private.
+typedef struct Query
+{
+   int row;
+   int column;
+   int position;
+} Query;
+
+// compareQueries()
+// qsort() comparison function that orders queries by row, then by column.
+// Private.
+int compareQueries(const void* a, const void* b)
+{
+   const Query* A = a;
+   const Query* B = b;
+
+   if( A->row != B->row )
    {
-      append(M->rows[i], E);
+      return (A->row > B->row) - (A->row < B->row);
    }
+   return (A->column > B->column) - (A->column < B->column);
 }
 
-// scalarMult()
-// returns a new Matrix that is the scalar product of this Matrix with x
-Matrix scalarMult(Matrix M, double x)
+// getEntries()
+// Sets out[k] to the value at row rows[k], column columns[k] of M, for
+// 0 <= k < count. The queries are sorted by row and column first, so every
+// row is walked at most once however many of them it answers.
+// pre: 1<=rows[k]<=getMatrixSize(M), 1<=columns[k]<=getMatrixSize(M)
+void getEntries(Matrix M, const int* rows, const int* columns, double* out,
+                int count)
 {
-   Matrix resultMatrix = newMatrix(M->dimensions);
-   
-   List oldRow = newList();
-   List resultRow = newList();
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling getEntries() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   Query* queries = malloc((count + 1) * sizeof(Query));
 
-   if (x != 0)
+   for( int k = 0; k < count; k++ )
    {
-      for( int i = 1; i <= M->dimensions; i++ )
+      if( rows[k] < 1 || rows[k] > M->dimensions
+          || columns[k] < 1 || columns[k] > M->dimensions )
+      {
+         printf( "Error: Program: Sparse, module: Matrix, precondition:"
+                 " getEntries() called with out of bounds arguments.");
+         exit(1);
+      }
+      queries[k].row = rows[k];
+      queries[k].column = columns[k];
+      queries[k].position = k;
+   }
+   qsort(queries, count, sizeof(Query), compareQueries);
+
+   for( int q = 0; q < count; )
+   {
+      int row = queries[q].row;
+      int end = q;
+
+      while( end < count && queries[end].row == row )
+      {
+         end++;
+      }
+      if( isRowHashed(M, row) )
+      {
+         for( ; q < end; q++ )
+         {
+            out[queries[q].position] =
+               hashedEntryData(M, row, queries[q].column);
+         }
+      }
+      else if( M->isCompressed )
+      {
+         // Each search starts where the one for the previous column ended.
+         int low = M->rowStart[row];
+
+         for( ; q < end; q++ )
+         {
+            int high = M->rowStart[row + 1];
+            while( low < high )
+            {
+               int middle = (low + high) / 2;
+               if( M->columns[middle] < queries[q].column )
+               {
+                  low = middle + 1;
+               }
+               else
+               {
+                  high = middle;
+               }
+            }
+            out[queries[q].position] =
+               (low < M->rowStart[row + 1]
+                && M->columns[low] == queries[q].column)
+               ? M->values[low] : 0.0;
+         }
+      }
+      else
       {
-         oldRow = M->rows[i];
-         resultRow = resultMatrix->rows[i];
+         ListIterator I = listBegin(M->rows[row]);
 
-         for( moveFront(oldRow); Index(oldRow)!= -1; moveNext(oldRow) )
+         for( ; q < end; q++ )
          {
-            Entry resultEntry = newEntry
-               (
-		getEntryColumn( get(oldRow) ),
-                getEntryData( get(oldRow) ) * x
-               );
-            append(resultRow, resultEntry);
+            while( !listAtEnd(I) && iteratorColumn(I) < queries[q].column )
+            {
+               iteratorNext(&I);
+            }
+            out[queries[q].position] =
+               (!listAtEnd(I) && iteratorColumn(I) == queries[q].column)
+               ? iteratorData(I) : 0.0;
          }
       }
    }
-   return resultMatrix;
+
+   free(queries);
 }
 
-// add()
-// returns a new Matrix that is the sum of this Matrix with M
-// pre: getMatrixSize()==M.getMatrixSize()
-Matrix add(Matrix L, Matrix R)
+// isMatrixCompressed()
+// Returns true if M keeps its entries in compressed sparse row form.
+bool isMatrixCompressed(Matrix M)
 {
-   if( getMatrixSize(L) != getMatrixSize(R) )
+   if( M == NULL )
    {
-      printf("Error: Program: Sparse, module: Matrix, precondition:"
-             " add() called with mismatching dimensions.");
+      printf("Matrix Error: calling isMatrixCompressed() on NULL Matrix"
+             " reference.\n");
       exit(1);
    }
-   Matrix resultMatrix = newMatrix(L->dimensions);
-   List leftRow = newList();
-   List rightRow = newList();
-
-   for( int i = 1; i <= L->dimensions; i++)
-   {
-      leftRow = L->rows[i];
-      rightRow = R->rows[i];
-      resultMatrix->rows[i] = addHelper(leftRow, rightRow, true);
-   }
-   return resultMatrix;
+   return M->isCompressed;
 }
 
-// sub()
-// returns a new Matrix that is the difference of this Matrix with M
-// pre: getMatrixSize()==M.getMatrixSize()
-Matrix sub(Matrix L, Matrix R)
+// rowBegin()
+// Returns an iterator under the first entry of row i of M. Walking a row
+// this way leaves it untouched, so many threads can read M at once.
+// Pre: 1 <= i <= getMatrixSize(M)
+RowIterator rowBegin(Matrix M, int i)
 {
-   if( getMatrixSize(L) != getMatrixSize(R) )
+   if( M == NULL )
    {
-      printf("Error: Program: Sparse, module: Matrix, precondition:"
-             " sub() called with mismatching dimensions.");
+      printf("Matrix Error: calling rowBegin() on NULL Matrix reference.\n");
       exit(1);
    }
-   Matrix resultMatrix = newMatrix(L->dimensions);
-   List leftRow = newList();
-   List rightRow = newList();
+   if( i < 1 || i > M->dimensions )
+   {
+      printf("Matrix Error: calling rowBegin() with a row out of bounds.\n");
+      exit(1);
+   }
+   RowIterator I;
 
-   for( int i = 1; i <= getMatrixSize(L); i++)
+   if( M->isCompressed )
    {
-      leftRow = L->rows[i];
-      rightRow = R->rows[i];
-      resultMatrix->rows[i] = addHelper(leftRow, rightRow, false);
+      I.columns = M->columns;
+      I.values = M->values;
+      I.position = M->rowStart[i];
+      I.end = M->rowStart[i + 1];
    }
-   return resultMatrix;
+   else
+   {
+      I.entry = listBegin(M->rows[i]);
+      I.columns = NULL;
+      I.values = NULL;
+      I.position = I.end = 0;
+   }
+   return I;
 }
 
-// transpose()
-// returns a new Matrix that is the transpose of this Matrix 
-Matrix transpose(Matrix M)
+// rowAtEnd()
+// Returns true if I has gone past the last entry of its row.
+bool rowAtEnd(RowIterator I)
 {
-   Matrix transposedMatrix = newMatrix(M->dimensions);
-   List currentRow = newList();
-
-   int column = 0;
-   double currentData = 0.0;
-
-   for( int row = 0; row <= M->dimensions; row++ )
-   {
-      currentRow = M->rows[row];
+   return (I.columns != NULL) ? I.position == I.end : listAtEnd(I.entry);
+}
 
-      for( moveFront(currentRow);
-           Index(currentRow) != -1;
-           moveNext(currentRow)
-      ){
-         column = getEntryColumn(get(currentRow));
-         currentData = getEntryData(get(currentRow));
+// rowColumn()
+// Returns the column of the entry under I.
+// Pre: !rowAtEnd(I)
+int rowColumn(RowIterator I)
+{
+   return (I.columns != NULL) ? I.columns[I.position]
+                              : iteratorColumn(I.entry);
+}
 
-         changeEntry(transposedMatrix, column, row, currentData);// index invert
-      }
-   }
-   return transposedMatrix;
+// rowData()
+// Returns the value of the entry under I.
+// Pre: !rowAtEnd(I)
+double rowData(RowIterator I)
+{
+   return (I.columns != NULL) ? I.values[I.position] : iteratorData(I.entry);
 }
 
-// mult()
-// Returns a new Matrix that is the product of this Matrix with M
-// pre: getMatrixSize()==M.getMatrixSize()
-Matrix mult(Matrix L, Matrix R)
+// rowNext()
+// Moves *pI to the next entry of its row.
+// Pre: !rowAtEnd(*pI)
+void rowNext(RowIterator* pI)
 {
-   if( getMatrixSize(L) != getMatrixSize(R) )
+   if( pI->columns != NULL )
    {
-      printf("Error: Program: Sparse, module: Matrix, precondition: mult()"
-             " called with mismatching dimensions.");
-      exit(1);
+      pI->position++;
    }
-   double entryData;
-    
-   Matrix resultMatrix = newMatrix(L->dimensions);
-   Matrix transposedR = newMatrix(L->dimensions);
-
-   List leftList = newList();
-   List rightList = newList();
-
-   transposedR = transpose(R);
-
-   for( int row = 1; row <= L->dimensions; row++ )
+   else
    {
-      leftList = L->rows[row];
-       
-      for( int column = 1; column <= L->dimensions; column++ )
-      {
-         rightList = transposedR->rows[column];
-         entryData = dot( leftList, rightList );
-         changeEntry(resultMatrix, row, column, entryData);
-      }
+      iteratorNext(&(pI->entry));
    }
-   return resultMatrix;  
 }
 
-// Other Functions ---------------------------------------------------------
-
-// matrixToString()
-// returns a text representation of the matrix.
-void matrixToString(FILE * out, Matrix M)
+// borrowRowArrays()
+// Points *pRowStart, *pColumns and *pValues at the compressed arrays of M,
+// laid out as matrixToArrays() does, copying the rows of M only if it is
+// not compressed. Returns true if the arrays are a copy that the caller
+// must free. Private.
+bool borrowRowArrays(Matrix M, int** pRowStart, int** pColumns,
+                     double** pValues)
 {
-   for(int i = 1; i <= M->dimensions; i++)
+   if( M->isCompressed )
    {
-      fprintf(out, "%d:", i);      
-      if( length(M->rows[i]) != 0 )
-      {
-         listToString(M->rows[i], out );
-      }
-      fprintf(out, "\n");
+      *pRowStart = M->rowStart;
+      *pColumns = M->columns;
+      *pValues = M->values;
+      return false;
    }
+   matrixToArrays(M, pRowStart, pColumns, pValues);
+   return true;
 }
 
-// dot()
-// Takes the dot product of two lists.
-double dot(List P, List Q)
+// returnRowArrays()
+// Frees arrays from borrowRowArrays() if they were a copy. Private.
+void returnRowArrays(bool isCopy, int* rowStart, int* columns,
+                     double* values)
 {
-   double returnValue = 0;
-   
-   int columnP = 0, columnQ = 0;
-
-   moveFront(P);
-   moveFront(Q);
-   while( Index(P) != -1 && Index(Q) != -1 )
+   if( isCopy )
    {
-      columnP = getEntryColumn(get(P));
-      columnQ = getEntryColumn(get(Q));
-
-      if( columnP == columnQ )
-      {
-         returnValue += getEntryData( get(P) ) * getEntryData( get(Q) );
-         moveNext(P);
-         moveNext(Q);
-      }
-      else if( columnP < columnQ )
-      {
-         moveNext(P);
-      }
-      else  /* columnQ < columnP */
-      {
-         moveNext(Q);
-      }
+      free(rowStart);
+      free(columns);
+      free(values);
    }
-   return returnValue; 
 }
 
-// Helper Functions --------------------------------------------------------
-
-// addHelper()
-// helper functions for add().
-List addHelper(List a, List b, bool isSum)
+// matrixMemoryUsage()
+// Returns the bytes held by M: the row lists and their nodes, with the
+// entries inside them, the array of rows and the matrixObj itself, the
+// table of hashMatrix() and the transpose kept by spmvT().
+MemoryUsage matrixMemoryUsage(Matrix M)
 {
-   List resultList = newList();
-   Entry resultEntry = newEntry(0,0.0); 
-   int columnNumberA = 0, columnNumberB = 0;
-   bool areSameList = false;
+   if( M == NULL )
+   {
+      printf("Matrix error: calling matrixMemoryUsage() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   MemoryUsage U = newMemoryUsage();
 
-   if( a == b )
+   if( M->hash != NULL )
    {
-      areSameList = true;
+      U.indexBytes = sizeof(EntryHashObj)
+                     + M->hash->capacity * (2 * sizeof(int) + sizeof(double));
+      U.allocations = 4;
    }
-   else
+   if( M->transposed != NULL )
    {
-      areSameList = false;
+      addMemoryUsage(&U, matrixMemoryUsage(M->transposed));
    }
-   if( length(a) == 0 && length(b) == 0 )
+   if( M->isCompressed )
    {
-      return resultList;
+      U.indexBytes += sizeof(MatrixObj) + (M->dimensions + 2) * sizeof(int);
+      U.entryBytes += (M->rowStart[M->dimensions + 1] + 1)
+                     * (sizeof(int) + sizeof(double));
+      U.allocations += 4;
+      return U;
    }
-   else if( length(a) == 0 ) 
+   U.indexBytes += sizeof(MatrixObj) + (M->dimensions + 1) * sizeof(List);
+   U.allocations += 2;
+   for( int i = 0; i <= M->dimensions; i++ )
    {
-      for( moveFront(b); Index(b) != -1; moveNext(b) )
+      addMemoryUsage(&U, listMemoryUsage(M->rows[i]));
+   }
+   return U;
+}
+
+// Manipulation procedures -------------------------------------------------
+
+// dropZeroEntries()
+// Removes the entries of the compressed M that hold 0.0, closing up the
+// arrays in place and shrinking them to fit. Private.
+void dropZeroEntries(Matrix M)
+{
+   int n = M->dimensions;
+   int nnz = M->rowStart[n + 1];
+   int start = 0, kept = 0;
+
+   for( int i = 1; i <= n; i++ )
+   {
+      int end = M->rowStart[i + 1];
+
+      for( int k = start; k < end; k++ )
       {
-         resultEntry->columnNumber = getEntryColumn(get(b));      
-         if( isSum )
-         {
-            resultEntry->data = getEntryData(get(b));
-         }
-         else
+         if( M->values[k] != 0.0 )
          {
-            resultEntry->data = -1 * getEntryData(get(b));
+            M->columns[kept] = M->columns[k];
+            M->values[kept++] = M->values[k];
          }
-         Entry NewEntry = copyEntry(resultEntry);
-	 append( resultList, NewEntry );
       }
-      return resultList;
+      M->rowStart[i + 1] = kept;
+      start = end;
    }
-   else if( length(b) == 0 )
+   if( kept < nnz )
    {
-      for( moveFront(a); Index(a) != -1; moveNext(a) )
-      {
-	 Entry NewEntry = copyEntry( get(a) );
-	 append( resultList, NewEntry );
-      }
-      return resultList;
+      M->columns = realloc(M->columns, (kept + 1) * sizeof(int));
+      M->values = realloc(M->values, (kept + 1) * sizeof(double));
+      countRelease((nnz - kept) * (sizeof(int) + sizeof(double)));
    }
-   moveFront(a);
-   moveFront(b);
-   while( Index(a) != -1 && Index(b) != -1 )
-   {
-      columnNumberA = getEntryColumn(get(a));
-      columnNumberB = getEntryColumn(get(b));
+}
 
-      if( columnNumberA == columnNumberB )
+// makeZero()
+// Puts the matrix back to its initial condition wehere there are no non-zero
+// entries.
+void makeZero(Matrix M)
+{
+   freeEntryHash(M);
+   freeTransposed(M);
+   if( M->isCompressed )
+   {
+      freeRowArrays(M);
+      M->rowStart = calloc(M->dimensions + 2, sizeof(int));
+      M->columns = malloc(sizeof(int));
+      M->values = malloc(sizeof(double));
+      countAllocation((M->dimensions + 2) * sizeof(int));
+      countAllocation(sizeof(int) + sizeof(double));
+      return;
+   }
+   for( int i = 1; i <= M->dimensions; i++ )
+   {
+      clear(M->rows[i]);
+   }
+}
+
+// changeEntry()
+// pre: 1<=i<=getMatrixSize(), 1<=j<=getMatrixSize()
+// changes ith row, jth column of this Matrix to x. On a compressed Matrix
+// an entry already there is overwritten in place, or removed if x is 0;
+// only a new entry expands the Matrix back to lists.
+void changeEntry(Matrix M, int i, int j, double x)
+{
+   if( i < 1 || i > getMatrixSize(M) || j < 1 || j > getMatrixSize(M) )
+   {
+      printf( "Error: Program: Sparse, module: Matrix, precondition:"
+              " changeEntry() called with out of bounds arguments.");
+      exit(1);
+   }
+   freeEntryHash(M);
+   freeTransposed(M);
+   if( M->isCompressed )
+   {
+      int k = findCompressedEntry(M, i, j);
+
+      // Only a new entry needs the row lists.
+      if( k >= 0 )
       {
-         resultEntry->columnNumber = columnNumberA;
-         if( isSum )
+         M->values[k] = x;
+         if( x == 0.0 )
          {
-            resultEntry->data =  getEntryData( get(a) ) + getEntryData( get(b) );
+            dropZeroEntries(M);
          }
-         else
+         return;
+      }
+      if( x == 0.0 )
+      {
+         return;
+      }
+   }
+   expandMatrix(M);
+   if( length(M->rows[i]) != 0.0 )
+   {
+      for( moveFront(M->rows[i]); Index(M->rows[i]) != -1; moveNext(M->rows[i]) )
+      {
+         if( getColumn(M->rows[i]) == j )
+         {
+            if( x == 0.0 )
+            {
+               delete(M->rows[i]);
+            }
+            else
+            {
+               setCursorData(M->rows[i], x);
+            }
+            break;
+         }
+         if( getColumn(M->rows[i]) > j )
          {
-            resultEntry->data = getEntryData( get(a) ) - getEntryData( get(b) );
+            if( x != 0.0 )
+            {
+               insertEntryBefore(M->rows[i], j, x);
+            }
+            break;
          }
+      }
+   }
+   if( Index(M->rows[i]) == -1 && x != 0 )
+   {
+      appendEntry(M->rows[i], j, x);
+   }
+}
+
+// hashMatrix()
+// Builds a table of the entries in the rows of M holding at least
+// HASHED_ROW_LENGTH entries, through which getMatrixEntryData() and
+// getEntries() find them in constant expected time. Any change to M drops
+// the table.
+void hashMatrix(Matrix M)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling hashMatrix() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   long long hashed = 0;
+   int capacity = 16;
+   EntryHashObj* H;
+
+   freeEntryHash(M);
+   for( int i = 1; i <= M->dimensions; i++ )
+   {
+      if( rowLength(M, i) >= HASHED_ROW_LENGTH )
+      {
+         hashed += rowLength(M, i);
+      }
+   }
+   if( hashed == 0 )
+   {
+      return;
+   }
+   while( capacity < 2 * hashed )
+   {
+      capacity *= 2;
+   }
+   H = malloc(sizeof(EntryHashObj));
+   H->capacity = capacity;
+   H->rows = calloc(capacity, sizeof(int));
+   H->columns = malloc(capacity * sizeof(int));
+   H->values = malloc(capacity * sizeof(double));
+   countAllocation(sizeof(EntryHashObj));
+   countAllocation(capacity * (2 * sizeof(int) + sizeof(double)));
 
-	 Entry NewEntry = copyEntry(resultEntry);
-    	 
-         if (resultEntry->data != 0.0)
+   for( int i = 1; i <= M->dimensions; i++ )
+   {
+      if( rowLength(M, i) < HASHED_ROW_LENGTH )
+      {
+         continue;
+      }
+      for( RowIterator I = rowBegin(M, i); !rowAtEnd(I); rowNext(&I) )
+      {
+         unsigned slot = hashSlot(i, rowColumn(I), capacity - 1);
+         while( H->rows[slot] != 0 )
          {
-	    append(resultList, NewEntry);
+            slot = (slot + 1) & (capacity - 1);
          }
-         moveNext(a);
-         if ( !areSameList )
+         H->rows[slot] = i;
+         H->columns[slot] = rowColumn(I);
+         H->values[slot] = rowData(I);
+      }
+   }
+   M->hash = H;
+}
+
+// unhashMatrix()
+// Frees the table built by hashMatrix(), if M has one.
+void unhashMatrix(Matrix M)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling unhashMatrix() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   freeEntryHash(M);
+}
+
+// compressMatrix()
+// Moves the entries of M into compressed sparse row form: one array of
+// columns and one of values, with every row stored contiguously in order.
+// Does nothing if M is already compressed.
+void compressMatrix(Matrix M)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling compressMatrix() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   if( M->isCompressed )
+   {
+      return;
+   }
+   int n = M->dimensions;
+
+   matrixToArrays(M, &(M->rowStart), &(M->columns), &(M->values));
+   countAllocation((n + 2) * sizeof(int));
+   countAllocation((M->rowStart[n + 1] + 1) * (sizeof(int) + sizeof(double)));
+   freeRowLists(M);
+   M->isCompressed = true;
+}
+
+// expandMatrix()
+// Moves the entries of a compressed M back into one List per row. Does
+// nothing if M is not compressed.
+void expandMatrix(Matrix M)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling expandMatrix() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   if( !M->isCompressed )
+   {
+      return;
+   }
+   int n = M->dimensions;
+
+   M->rows = malloc((n + 1) * sizeof(List));
+   countAllocation((n + 1) * sizeof(List));
+   for( int i = 0; i <= n; i++ )
+   {
+      M->rows[i] = newList();
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      for( int k = M->rowStart[i]; k < M->rowStart[i + 1]; k++ )
+      {
+         appendEntry(M->rows[i], M->columns[k], M->values[k]);
+      }
+   }
+   freeRowArrays(M);
+   M->isCompressed = false;
+}
+
+// Triple type. Private.
+typedef struct Triple
+{
+   int column;
+   int position;
+   double data;
+} Triple;
+
+// compareTriples()
+// qsort() comparison function that orders triples by column, then by their
+// position in the input. Private.
+int compareTriples(const void* a, const void* b)
+{
+   const Triple* tripleA = a;
+   const Triple* tripleB = b;
+   if( tripleA->column != tripleB->column )
+   {
+      return (tripleA->column > tripleB->column) ? 1 : -1;
+   }
+   return (tripleA->position > tripleB->position)
+          - (tripleA->position < tripleB->position);
+}
+
+// buildMatrix()
+// returns a new n by n Matrix holding the count entries given as triples
+// (rows[k], columns[k], values[k]) in any order. Leaves the Matrix as
+// calling changeEntry() on every triple in turn would, so the last of
+// repeated positions wins, but sorts each row once instead.
+// pre: 1<=rows[k]<=n, 1<=columns[k]<=n
+Matrix buildMatrix(int n, int* rows, int* columns, double* values,
+                   int count)
+{
+   Matrix M = newMatrix(n);
+   int* start = calloc(n + 2, sizeof(int));
+   Triple* triples = malloc((count + 1) * sizeof(Triple));
+
+   for( int k = 0; k < count; k++ )
+   {
+      if( rows[k] < 1 || rows[k] > n || columns[k] < 1 || columns[k] > n )
+      {
+         printf( "Error: Program: Sparse, module: Matrix, precondition:"
+                 " buildMatrix() called with out of bounds triples.");
+         exit(1);
+      }
+      start[rows[k] + 1]++;
+   }
+   for( int i = 1; i <= n; i++ )
+   {
+      start[i + 1] += start[i];
+   }
+   for( int k = 0; k < count; k++ )
+   {
+      Triple* T = &triples[start[rows[k]]++];
+      T->column = columns[k];
+      T->position = k;
+      T->data = values[k];
+   }
+   // start[i] now marks the end of row i, which is where row i + 1 begins.
+   #pragma omp parallel for schedule(dynamic, 64)
+   for( int i = 1; i <= n; i++ )
+   {
+      int first = start[i - 1], last = start[i];
+
+      qsort(triples + first, last - first, sizeof(Triple), compareTriples);
+      for( int k = first; k < last; k++ )
+      {
+         if( (k + 1 == last || triples[k + 1].column != triples[k].column)
+             && triples[k].data != 0.0 )
          {
-	    printf("moved next.\n");
-            moveNext(b);
-	 }
+            appendEntry(M->rows[i], triples[k].column, triples[k].data);
+         }
       }
-      else if( columnNumberA < columnNumberB  )
+   }
+
+   free(start);
+   free(triples);
+   return M;
+}
+
+// compareEntries()
+// qsort() comparison function that orders entries by column. Private.
+int compareEntries(const void* a, const void* b)
+{
+   int columnA = ((const EntryObj*)a)->columnNumber;
+   int columnB = ((const EntryObj*)b)->columnNumber;
+   return (columnA > columnB) - (columnA < columnB);
+}
+
+// buildCompressedMatrix()
+// returns a new compressed n by n Matrix holding the count entries given as
+// triples (rows[k], columns[k], values[k]) in any order. Repeated positions
+// are summed and entries that sum to zero are dropped. Takes O(n + count)
+// time plus sorting each row, and a handful of mallocs.
+// pre: 1<=rows[k]<=n, 1<=columns[k]<=n
+Matrix buildCompressedMatrix(int n, int* rows, int* columns, double* values,
+                             int count)
+{
+   int* start = calloc(n + 2, sizeof(int));
+   int* next = malloc((n + 2) * sizeof(int));
+   EntryObj* entries = malloc((count + 1) * sizeof(EntryObj));
+   Matrix M;
+
+   for( int k = 0; k < count; k++ )
+   {
+      if( rows[k] < 1 || rows[k] > n || columns[k] < 1 || columns[k] > n )
       {
-         Entry NewEntry = copyEntry( get(a) );
-         append(resultList, NewEntry);
-         moveNext(a);
+         printf( "Error: Program: Sparse, module: Matrix, precondition:"
+                 " buildCompressedMatrix() called with out of bounds"
+                 " triples.");
+         exit(1);
       }
-      else
+      start[rows[k] + 1]++;
+   }
+   for( int i = 1; i <= n; i++ )
+   {
+      start[i + 1] += start[i];
+   }
+   memcpy(next, start, (n + 2) * sizeof(int));
+   for( int k = 0; k < count; k++ )
+   {
+      EntryObj* E = &entries[next[rows[k]]++];
+      E->columnNumber = columns[k];
+      E->data = values[k];
+   }
+
+   // Sort every row, then sum repeated columns and drop zeros in place,
+   // leaving the length of row i in next[i].
+   #pragma omp parallel for schedule(dynamic, 64)
+   for( int i = 1; i <= n; i++ )
+   {
+      EntryObj* row = entries + start[i];
+      int rowLength = start[i + 1] - start[i];
+      int kept = 0;
+
+      qsort(row, rowLength, sizeof(EntryObj), compareEntries);
+      for( int k = 0; k < rowLength; )
       {
-         resultEntry->columnNumber = getEntryColumn(get(b));
+         int column = row[k].columnNumber;
+         double sum = 0.0;
 
-	 if( isSum )
+         while( k < rowLength && row[k].columnNumber == column )
          {
-            resultEntry->data = getEntryData(get(b));
-         } 
-         else
+            sum += row[k++].data;
+         }
+         if( sum != 0.0 )
          {
-            resultEntry->data = -1 * getEntryData( get(b) );
+            row[kept].columnNumber = column;
+            row[kept++].data = sum;
          }
-         Entry NewEntry = copyEntry(resultEntry);
-         append(resultList, NewEntry);
-         moveNext(b);
       }
+      next[i] = kept;
+   }
+
+   int nnz = 0;
+   for( int i = 1; i <= n; i++ )
+   {
+      nnz += next[i];
+   }
+   M = newCompressedMatrix(n, nnz);
+   for( int i = 1; i <= n; i++ )
+   {
+      M->rowStart[i + 1] = M->rowStart[i] + next[i];
    }
-   if( Index(a) != -1 )
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
    {
-      do
+      for( int k = 0; k < next[i]; k++ )
       {
-         Entry NewEntry = copyEntry(get(a));
-         append( resultList, NewEntry );
-         moveNext(a);
+         M->columns[M->rowStart[i] + k] = entries[start[i] + k].columnNumber;
+         M->values[M->rowStart[i] + k] = entries[start[i] + k].data;
       }
-      while( Index(a) != -1 );
    }
-   if( Index(b) != -1) 
+
+   free(start);
+   free(next);
+   free(entries);
+   return M;
+}
+
+// scalarMult()
+// returns a new Matrix that is the scalar product of this Matrix with x
+Matrix scalarMult(Matrix M, double x)
+{
+   if( M->isCompressed )
    {
-      if( isSum )
+      int n = M->dimensions;
+      int nnz = (x != 0) ? M->rowStart[n + 1] : 0;
+      Matrix resultMatrix = newCompressedMatrix(n, nnz);
+
+      if( x != 0 )
       {
-         do
+         memcpy(resultMatrix->rowStart, M->rowStart, (n + 2) * sizeof(int));
+         memcpy(resultMatrix->columns, M->columns, nnz * sizeof(int));
+         #pragma omp parallel for
+         for( int k = 0; k < nnz; k++ )
          {
-            Entry NewEntry = copyEntry( get(b) );
-            append( resultList, NewEntry );
-            moveNext( b );
+            resultMatrix->values[k] = M->values[k] * x;
          }
-         while( Index(b) != -1 );
       }
-      else 
+      return resultMatrix;
+   }
+   Matrix resultMatrix = newMatrix(M->dimensions);
+
+   if (x != 0)
+   {
+      for( int i = 1; i <= M->dimensions; i++ )
       {
-         do
+         List resultRow = resultMatrix->rows[i];
+
+         for( ListIterator I = listBegin(M->rows[i]); !listAtEnd(I);
+              iteratorNext(&I) )
          {
-            resultEntry->data = -1 * getEntryData( get(b) );
-            resultEntry->columnNumber = getEntryColumn( get(b) );
+            appendEntry(resultRow, iteratorColumn(I), iteratorData(I) * x);
+         }
+      }
+   }
+   return resultMatrix;
+}
+
+// mergeRows()
+// Merges the sorted rows a and b into a + sign * b, leaving out entries
+// that cancel, and returns its length. The merged row is stored in columns
+// and values unless they are NULL. Private.
+int mergeRows(const int* columnsA, const double* valuesA, int countA,
+              const int* columnsB, const double* valuesB, int countB,
+              double sign, int* columns, double* values)
+{
+   int a = 0, b = 0, count = 0;
+
+   while( a < countA || b < countB )
+   {
+      int column;
+      double data;
 
-	    Entry NewEntry = copyEntry( resultEntry );
-            append(resultList, NewEntry);
-            moveNext(b);
+      if( b == countB || ( a < countA && columnsA[a] < columnsB[b] ) )
+      {
+         column = columnsA[a];
+         data = valuesA[a++];
+      }
+      else if( a == countA || columnsB[b] < columnsA[a] )
+      {
+         column = columnsB[b];
+         data = sign * valuesB[b++];
+      }
+      else
+      {
+         column = columnsA[a];
+         data = valuesA[a++] + sign * valuesB[b++];
+      }
+      if( data != 0.0 )
+      {
+         if( columns != NULL )
+         {
+            columns[count] = column;
+            values[count] = data;
          }
-         while( Index(b) != -1 );
+         count++;
       }
    }
-return resultList;
+   return count;
+}
+
+// addCompressed()
+// Returns the compressed L + sign * R, sizing every row in a first pass
+// and filling them in a second, both split among threads. Private.
+Matrix addCompressed(Matrix L, Matrix R, double sign)
+{
+   int n = L->dimensions;
+   int *startL, *columnsL, *startR, *columnsR;
+   double *valuesL, *valuesR;
+   bool isCopyL = borrowRowArrays(L, &startL, &columnsL, &valuesL);
+   bool isCopyR = borrowRowArrays(R, &startR, &columnsR, &valuesR);
+   int* rowLength = malloc((n + 1) * sizeof(int));
+   int nnz = 0;
+   Matrix S;
+
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      rowLength[i] = mergeRows(columnsL + startL[i], valuesL + startL[i],
+                               startL[i + 1] - startL[i],
+                               columnsR + startR[i], valuesR + startR[i],
+                               startR[i + 1] - startR[i], sign, NULL, NULL);
+   }
+   for( int i = 1; i <= n; i++ )
+   {
+      nnz += rowLength[i];
+   }
+   S = newCompressedMatrix(n, nnz);
+   for( int i = 1; i <= n; i++ )
+   {
+      S->rowStart[i + 1] = S->rowStart[i] + rowLength[i];
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      mergeRows(columnsL + startL[i], valuesL + startL[i],
+                startL[i + 1] - startL[i],
+                columnsR + startR[i], valuesR + startR[i],
+                startR[i + 1] - startR[i], sign,
+                S->columns + S->rowStart[i], S->values + S->rowStart[i]);
+   }
+
+   free(rowLength);
+   returnRowArrays(isCopyL, startL, columnsL, valuesL);
+   returnRowArrays(isCopyR, startR, columnsR, valuesR);
+   return S;
+}
+
+// add()
+// returns a new Matrix that is the sum of this Matrix with M
+// pre: getMatrixSize()==M.getMatrixSize()
+Matrix add(Matrix L, Matrix R)
+{
+   if( getMatrixSize(L) != getMatrixSize(R) )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " add() called with mismatching dimensions.");
+      exit(1);
+   }
+   if( L->isCompressed || R->isCompressed )
+   {
+      return addCompressed(L, R, 1.0);
+   }
+   Matrix resultMatrix = newMatrix(L->dimensions);
+
+   for( int i = 1; i <= L->dimensions; i++)
+   {
+      freeList(&(resultMatrix->rows[i]));
+      resultMatrix->rows[i] = addHelper(L->rows[i], R->rows[i], true);
+   }
+   return resultMatrix;
+}
+
+// sub()
+// returns a new Matrix that is the difference of this Matrix with M
+// pre: getMatrixSize()==M.getMatrixSize()
+Matrix sub(Matrix L, Matrix R)
+{
+   if( getMatrixSize(L) != getMatrixSize(R) )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " sub() called with mismatching dimensions.");
+      exit(1);
+   }
+   if( L->isCompressed || R->isCompressed )
+   {
+      return addCompressed(L, R, -1.0);
+   }
+   Matrix resultMatrix = newMatrix(L->dimensions);
+
+   for( int i = 1; i <= getMatrixSize(L); i++)
+   {
+      freeList(&(resultMatrix->rows[i]));
+      resultMatrix->rows[i] = addHelper(L->rows[i], R->rows[i], false);
+   }
+   return resultMatrix;
 }
 
+// Value arrays are split among threads in blocks of this many entries.
+#define VALUE_BLOCK 4096
+
+// On x86-64 the AVX2 kernels below are compiled whatever flags the build
+// uses, and each call takes them only if the processor has AVX2 and FMA.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define AVX2_KERNELS
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+// hasAvx2()
+// Returns true if the processor running the program has AVX2 and FMA.
+// Private.
+bool hasAvx2(void)
+{
+#if defined(__AVX2__) && defined(__FMA__)
+   return true;
+#else
+   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+
+// scaleValuesAvx2()
+// Multiplies y[0..count-1] by alpha four entries at a time, and returns
+// how many entries it did. Private.
+AVX2_TARGET int scaleValuesAvx2(double* y, double alpha, int count)
+{
+   __m256d scale = _mm256_set1_pd(alpha);
+   int k = 0;
+
+   for( ; k + 4 <= count; k += 4 )
+   {
+      _mm256_storeu_pd(y + k, _mm256_mul_pd(_mm256_loadu_pd(y + k), scale));
+   }
+   return k;
+}
+
+// scaleAddValuesAvx2()
+// Adds alpha x[0..count-1] to y[0..count-1] four entries at a time, and
+// returns how many entries it did. Private.
+AVX2_TARGET int scaleAddValuesAvx2(double* y, double alpha, const double* x,
+                                   int count)
+{
+   __m256d scale = _mm256_set1_pd(alpha);
+   int k = 0;
+
+   for( ; k + 4 <= count; k += 4 )
+   {
+      _mm256_storeu_pd(y + k, _mm256_fmadd_pd(scale, _mm256_loadu_pd(x + k),
+                                               _mm256_loadu_pd(y + k)));
+   }
+   return k;
+}
+
+// multiplyValuesAvx2()
+// Multiplies y[0..count-1] by x[0..count-1] four entries at a time, and
+// returns how many entries it did. Private.
+AVX2_TARGET int multiplyValuesAvx2(double* y, const double* x, int count)
+{
+   int k = 0;
+
+   for( ; k + 4 <= count; k += 4 )
+   {
+      _mm256_storeu_pd(y + k, _mm256_mul_pd(_mm256_loadu_pd(y + k),
+                                            _mm256_loadu_pd(x + k)));
+   }
+   return k;
+}
+
+// rowTimesVectorAvx2()
+// Sets *pSum to the dot product of the first entries in columns and values
+// with x, four at a time with gathers and fused multiply adds, and returns
+// how many entries it did. Private.
+AVX2_TARGET int rowTimesVectorAvx2(const int* columns, const double* values,
+                                   int count, const double* x, double* pSum)
+{
+   __m256d partial = _mm256_setzero_pd();
+   double lanes[4];
+   int k = 0;
+
+   for( ; k + 4 <= count; k += 4 )
+   {
+      __m128i index = _mm_loadu_si128((const __m128i*)(columns + k));
+      __m256d gathered = _mm256_i32gather_pd(x, index, sizeof(double));
+      partial = _mm256_fmadd_pd(_mm256_loadu_pd(values + k), gathered,
+                                partial);
+   }
+   _mm256_storeu_pd(lanes, partial);
+   *pSum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+   return k;
+}
+#endif
+
+// scaleValues()
+// Multiplies y[0..count-1] by alpha. Private.
+void scaleValues(double* y, double alpha, int count)
+{
+   int k = 0;
+
+#ifdef AVX2_KERNELS
+   if( hasAvx2() )
+   {
+      k = scaleValuesAvx2(y, alpha, count);
+   }
+#endif
+   for( ; k < count; k++ )
+   {
+      y[k] *= alpha;
+   }
+}
+
+// scaleAddValues()
+// Adds alpha x[0..count-1] to y[0..count-1]. Private.
+void scaleAddValues(double* y, double alpha, const double* x, int count)
+{
+   int k = 0;
+
+#ifdef AVX2_KERNELS
+   if( hasAvx2() )
+   {
+      k = scaleAddValuesAvx2(y, alpha, x, count);
+   }
+#endif
+   for( ; k < count; k++ )
+   {
+      y[k] += alpha * x[k];
+   }
+}
+
+// multiplyValues()
+// Multiplies y[0..count-1] by x[0..count-1], entry by entry. Private.
+void multiplyValues(double* y, const double* x, int count)
+{
+   int k = 0;
+
+#ifdef AVX2_KERNELS
+   if( hasAvx2() )
+   {
+      k = multiplyValuesAvx2(y, x, count);
+   }
+#endif
+   for( ; k < count; k++ )
+   {
+      y[k] *= x[k];
+   }
+}
+
+// isRowSubset()
+// Returns true if every column in the sorted row a is also in the sorted
+// row b. Private.
+bool isRowSubset(const int* columnsA, int countA, const int* columnsB,
+                 int countB)
+{
+   int b = 0;
+
+   if( countA > countB )
+   {
+      return false;
+   }
+   for( int a = 0; a < countA; a++ )
+   {
+      while( b < countB && columnsB[b] < columnsA[a] )
+      {
+         b++;
+      }
+      if( b == countB || columnsB[b] != columnsA[a] )
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// matrixScaleInPlace()
+// Multiplies every entry of M by alpha without allocating. An alpha of 0
+// empties M.
+void matrixScaleInPlace(Matrix M, double alpha)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling matrixScaleInPlace() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   if( alpha == 0.0 )
+   {
+      makeZero(M);
+      return;
+   }
+   freeEntryHash(M);
+   freeTransposed(M);
+   if( M->isCompressed )
+   {
+      int nnz = M->rowStart[M->dimensions + 1];
+
+      #pragma omp parallel for schedule(static)
+      for( int k = 0; k < nnz; k += VALUE_BLOCK )
+      {
+         scaleValues(M->values + k, alpha,
+                     (nnz - k < VALUE_BLOCK) ? nnz - k : VALUE_BLOCK);
+      }
+      return;
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= M->dimensions; i++ )
+   {
+      for( ListIterator I = listBegin(M->rows[i]); !listAtEnd(I);
+           iteratorNext(&I) )
+      {
+         setData(iteratorEntry(I), iteratorData(I) * alpha);
+      }
+   }
+}
+
+// axpyCompressed()
+// Adds alpha X to the compressed Y. When every row of X only has entries
+// where Y does, the values of Y are updated where they lie, a whole row at
+// a time when the two rows match; otherwise the rows are merged into new
+// arrays. Private.
+void axpyCompressed(Matrix Y, double alpha, Matrix X)
+{
+   int n = Y->dimensions;
+   int *startX, *columnsX;
+   double* valuesX;
+   bool isCopy = borrowRowArrays(X, &startX, &columnsX, &valuesX);
+   bool isSubset = true;
+   bool hasZeros = false;
+
+   #pragma omp parallel for schedule(dynamic, 256) reduction(&&:isSubset)
+   for( int i = 1; i <= n; i++ )
+   {
+      isSubset = isSubset
+         && isRowSubset(columnsX + startX[i], startX[i + 1] - startX[i],
+                        Y->columns + Y->rowStart[i],
+                        Y->rowStart[i + 1] - Y->rowStart[i]);
+   }
+   if( isSubset )
+   {
+      #pragma omp parallel for schedule(dynamic, 256) reduction(||:hasZeros)
+      for( int i = 1; i <= n; i++ )
+      {
+         int countX = startX[i + 1] - startX[i];
+         int countY = Y->rowStart[i + 1] - Y->rowStart[i];
+         double* values = Y->values + Y->rowStart[i];
+
+         if( countX == countY )
+         {
+            scaleAddValues(values, alpha, valuesX + startX[i], countX);
+         }
+         else
+         {
+            const int* columns = Y->columns + Y->rowStart[i];
+            int k = 0;
+
+            for( int m = startX[i]; m < startX[i + 1]; m++ )
+            {
+               while( columns[k] < columnsX[m] )
+               {
+                  k++;
+               }
+               values[k] += alpha * valuesX[m];
+            }
+         }
+         for( int k = 0; k < countY; k++ )
+         {
+            hasZeros = hasZeros || values[k] == 0.0;
+         }
+      }
+      if( hasZeros )
+      {
+         dropZeroEntries(Y);
+      }
+      returnRowArrays(isCopy, startX, columnsX, valuesX);
+      return;
+   }
+
+   int* rowStart = malloc((n + 2) * sizeof(int));
+   int *columns;
+   double* values;
+   int nnz = Y->rowStart[n + 1];
+
+   rowStart[0] = rowStart[1] = 0;
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      rowStart[i + 1] = mergeRows(Y->columns + Y->rowStart[i],
+                                  Y->values + Y->rowStart[i],
+                                  Y->rowStart[i + 1] - Y->rowStart[i],
+                                  columnsX + startX[i], valuesX + startX[i],
+                                  startX[i + 1] - startX[i], alpha,
+                                  NULL, NULL);
+   }
+   for( int i = 1; i <= n; i++ )
+   {
+      rowStart[i + 1] += rowStart[i];
+   }
+   columns = malloc((rowStart[n + 1] + 1) * sizeof(int));
+   values = malloc((rowStart[n + 1] + 1) * sizeof(double));
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      mergeRows(Y->columns + Y->rowStart[i], Y->values + Y->rowStart[i],
+                Y->rowStart[i + 1] - Y->rowStart[i],
+                columnsX + startX[i], valuesX + startX[i],
+                startX[i + 1] - startX[i], alpha,
+                columns + rowStart[i], values + rowStart[i]);
+   }
+   countRelease((nnz + 1) * (sizeof(int) + sizeof(double)));
+   countAllocation((rowStart[n + 1] + 1) * (sizeof(int) + sizeof(double)));
+   free(Y->columns);
+   free(Y->values);
+   memcpy(Y->rowStart, rowStart, (n + 2) * sizeof(int));
+   Y->columns = columns;
+   Y->values = values;
+
+   free(rowStart);
+   returnRowArrays(isCopy, startX, columnsX, valuesX);
+}
+
+// matrixAxpy()
+// Adds alpha X to Y in place, leaving out entries that cancel. Y keeps its
+// storage mode, and is updated without allocating when X only has entries
+// where Y does.
+// pre: getMatrixSize(Y)==getMatrixSize(X)
+void matrixAxpy(Matrix Y, double alpha, Matrix X)
+{
+   if( Y == NULL || X == NULL )
+   {
+      printf("Matrix Error: calling matrixAxpy() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   if( getMatrixSize(Y) != getMatrixSize(X) )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " matrixAxpy() called with mismatching dimensions.");
+      exit(1);
+   }
+   if( Y == X )
+   {
+      matrixScaleInPlace(Y, 1.0 + alpha);
+      return;
+   }
+   if( alpha == 0.0 )
+   {
+      return;
+   }
+   freeEntryHash(Y);
+   freeTransposed(Y);
+   if( Y->isCompressed )
+   {
+      axpyCompressed(Y, alpha, X);
+      return;
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= Y->dimensions; i++ )
+   {
+      List row = Y->rows[i];
+
+      moveFront(row);
+      for( RowIterator J = rowBegin(X, i); !rowAtEnd(J); rowNext(&J) )
+      {
+         int column = rowColumn(J);
+         double data = alpha * rowData(J);
+
+         while( Index(row) != -1 && getColumn(row) < column )
+         {
+            moveNext(row);
+         }
+         if( Index(row) == -1 )
+         {
+            if( data != 0.0 )
+            {
+               appendEntry(row, column, data);
+            }
+         }
+         else if( getColumn(row) == column )
+         {
+            if( getData(row) + data == 0.0 )
+            {
+               deleteAndMoveNext(row);
+            }
+            else
+            {
+               setCursorData(row, getData(row) + data);
+            }
+         }
+         else if( data != 0.0 )
+         {
+            insertEntryBefore(row, column, data);
+         }
+      }
+   }
+}
+
+// matrixHadamardInPlace()
+// Multiplies every entry of Y by the entry of X at the same place, the
+// entries of Y with none in X becoming zero, without allocating.
+// pre: getMatrixSize(Y)==getMatrixSize(X)
+void matrixHadamardInPlace(Matrix Y, Matrix X)
+{
+   if( Y == NULL || X == NULL )
+   {
+      printf("Matrix Error: calling matrixHadamardInPlace() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   if( getMatrixSize(Y) != getMatrixSize(X) )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " matrixHadamardInPlace() called with mismatching"
+             " dimensions.");
+      exit(1);
+   }
+   freeEntryHash(Y);
+   freeTransposed(Y);
+   if( Y->isCompressed )
+   {
+      bool hasZeros = false;
+
+      #pragma omp parallel for schedule(dynamic, 256) reduction(||:hasZeros)
+      for( int i = 1; i <= Y->dimensions; i++ )
+      {
+         const int* columns = Y->columns + Y->rowStart[i];
+         double* values = Y->values + Y->rowStart[i];
+         int count = Y->rowStart[i + 1] - Y->rowStart[i];
+
+         if( X->isCompressed
+             && X->rowStart[i + 1] - X->rowStart[i] == count
+             && memcmp(columns, X->columns + X->rowStart[i],
+                       count * sizeof(int)) == 0 )
+         {
+            multiplyValues(values, X->values + X->rowStart[i], count);
+         }
+         else
+         {
+            RowIterator J = rowBegin(X, i);
+
+            for( int k = 0; k < count; k++ )
+            {
+               while( !rowAtEnd(J) && rowColumn(J) < columns[k] )
+               {
+                  rowNext(&J);
+               }
+               values[k] *= (!rowAtEnd(J) && rowColumn(J) == columns[k])
+                            ? rowData(J) : 0.0;
+            }
+         }
+         for( int k = 0; k < count; k++ )
+         {
+            hasZeros = hasZeros || values[k] == 0.0;
+         }
+      }
+      if( hasZeros )
+      {
+         dropZeroEntries(Y);
+      }
+      return;
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= Y->dimensions; i++ )
+   {
+      List row = Y->rows[i];
+      RowIterator J = rowBegin(X, i);
+
+      moveFront(row);
+      while( Index(row) != -1 )
+      {
+         int column = getColumn(row);
+         double product;
+
+         while( !rowAtEnd(J) && rowColumn(J) < column )
+         {
+            rowNext(&J);
+         }
+         product = (!rowAtEnd(J) && rowColumn(J) == column)
+                   ? getData(row) * rowData(J) : 0.0;
+         if( product == 0.0 )
+         {
+            deleteAndMoveNext(row);
+         }
+         else
+         {
+            setCursorData(row, product);
+            moveNext(row);
+         }
+      }
+   }
+}
+
+// splitRowsByEntries()
+// Splits rows 1..n, laid out as matrixToArrays() does, into parts ranges
+// of consecutive rows holding about the same number of entries. Range p is
+// firstRow[p] up to but not including firstRow[p + 1]. Private.
+void splitRowsByEntries(int n, const int* rowStart, int parts, int* firstRow)
+{
+   long long nnz = rowStart[n + 1];
+
+   firstRow[0] = 1;
+   for( int p = 1; p < parts; p++ )
+   {
+      int goal = (int)(nnz * p / parts);
+      int low = firstRow[p - 1], high = n + 1;
+
+      // The first row that starts at or after the goal.
+      while( low < high )
+      {
+         int middle = low + (high - low) / 2;
+         if( rowStart[middle] < goal )
+         {
+            low = middle + 1;
+         }
+         else
+         {
+            high = middle;
+         }
+      }
+      firstRow[p] = low;
+   }
+   firstRow[parts] = n + 1;
+}
+
+// Below this many entries transpose() runs on one thread.
+#define TRANSPOSE_PARALLEL_ENTRIES 65536
+
+// transposeArrays()
+// Returns the compressed transpose of the n by n matrix stored in rowStart,
+// columns and values as matrixToArrays() lays it out, in O(n + nnz) time:
+// it counts the entries of every column, takes prefix sums and scatters the
+// rows in order. Each thread counts and scatters its own range of rows,
+// which lands after the ranges before it in every column. Every range
+// keeps a count per column, so there are at most 1 + nnz / (n + 1) ranges
+// and the counts take O(n + nnz) space. Private.
+Matrix transposeArrays(int n, const int* rowStart, const int* columns,
+                       const double* values)
+{
+   int nnz = rowStart[n + 1];
+   Matrix T = newCompressedMatrix(n, nnz);
+   int parts = 1;
+
+#ifdef _OPENMP
+   if( nnz >= TRANSPOSE_PARALLEL_ENTRIES )
+   {
+      parts = omp_get_max_threads();
+      if( parts > 1 + nnz / (n + 1) )
+      {
+         parts = 1 + nnz / (n + 1);
+      }
+   }
+#endif
+   int* firstRow = malloc((parts + 1) * sizeof(int));
+   int* next = calloc((size_t)parts * (n + 1), sizeof(int));
+
+   splitRowsByEntries(n, rowStart, parts, firstRow);
+   #pragma omp parallel for schedule(static, 1)
+   for( int p = 0; p < parts; p++ )
+   {
+      int* count = next + (size_t)p * (n + 1);
+      for( int k = rowStart[firstRow[p]]; k < rowStart[firstRow[p + 1]]; k++ )
+      {
+         count[columns[k]]++;
+      }
+   }
+
+   // Turn the counts into the position where each range starts writing in
+   // every column.
+   int position = 0;
+   for( int j = 1; j <= n; j++ )
+   {
+      T->rowStart[j] = position;
+      for( int p = 0; p < parts; p++ )
+      {
+         int* slot = next + (size_t)p * (n + 1) + j;
+         int count = *slot;
+         *slot = position;
+         position += count;
+      }
+   }
+   T->rowStart[n + 1] = position;
+
+   #pragma omp parallel for schedule(static, 1)
+   for( int p = 0; p < parts; p++ )
+   {
+      int* place = next + (size_t)p * (n + 1);
+      for( int i = firstRow[p]; i < firstRow[p + 1]; i++ )
+      {
+         for( int k = rowStart[i]; k < rowStart[i + 1]; k++ )
+         {
+            int target = place[columns[k]]++;
+            T->columns[target] = i;
+            T->values[target] = values[k];
+         }
+      }
+   }
+
+   free(firstRow);
+   free(next);
+   return T;
+}
+
+// transpose()
+// returns a new Matrix that is the transpose of this Matrix, in the same
+// storage mode. Takes O(n + nnz) time.
+Matrix transpose(Matrix M)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling transpose() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   int *rowStart, *columns;
+   double* values;
+   bool isCopy = borrowRowArrays(M, &rowStart, &columns, &values);
+   Matrix T = transposeArrays(M->dimensions, rowStart, columns, values);
+
+   returnRowArrays(isCopy, rowStart, columns, values);
+   if( !M->isCompressed )
+   {
+      expandMatrix(T);
+   }
+   return T;
+}
+
+// compareColumns()
+// qsort() comparison function for ints. Private.
+int compareColumns(const void* a, const void* b)
+{
+   int columnA = *(const int*)a;
+   int columnB = *(const int*)b;
+   return (columnA > columnB) - (columnA < columnB);
+}
+
+// A row of a product that may reach n / DENSE_ROW_FRACTION entries is
+// gathered in a dense array indexed by column, a sparser row in a hash
+// table sized to the row.
+#define DENSE_ROW_FRACTION 16
+
+// RowAccumulator
+// The scratch space one thread uses to gather rows of a product. Private.
+typedef struct RowAccumulator
+{
+   int n;
+   int stamp;           // the mark of the row being gathered
+   int* marker;         // marker[column] == stamp once the row touches it
+   double* dense;
+   int capacity;        // hash slots, a power of two
+   int* keys;           // the column held in each slot, 0 when empty
+   double* sums;
+   int* touched;        // the columns met so far, in the order met
+   int touchedCapacity;
+} RowAccumulator;
+
+// newRowAccumulator()
+// Returns an empty RowAccumulator for products of size n. Its arrays are
+// allocated on first use. Private.
+RowAccumulator newRowAccumulator(int n)
+{
+   RowAccumulator A;
+
+   A.n = n;
+   A.stamp = 0;
+   A.marker = A.keys = A.touched = NULL;
+   A.dense = A.sums = NULL;
+   A.capacity = A.touchedCapacity = 0;
+   return A;
+}
+
+// freeRowAccumulator()
+// Frees the arrays of *pA. Private.
+void freeRowAccumulator(RowAccumulator* pA)
+{
+   free(pA->marker);
+   free(pA->dense);
+   free(pA->keys);
+   free(pA->sums);
+   free(pA->touched);
+}
+
+// The operations of each semiring, as macros that specialize the kernels
+// below at compile time.
+#define ADD_PLUS(a, b)       ((a) + (b))
+#define MULTIPLY_TIMES(a, b) ((a) * (b))
+#define ADD_MIN(a, b)        ((a) < (b) ? (a) : (b))
+#define MULTIPLY_PLUS(a, b)  ((a) + (b))
+#define ADD_OR(a, b)         (((a) != 0.0 || (b) != 0.0) ? 1.0 : 0.0)
+#define MULTIPLY_AND(a, b)   (((a) != 0.0 && (b) != 0.0) ? 1.0 : 0.0)
+
+// semiringZero()
+// Returns the identity of the addition of semiring, which an entry absent
+// from a Matrix stands for. Private.
+double semiringZero(int semiring)
+{
+   return (semiring == SEMIRING_MIN_PLUS) ? INFINITY : 0.0;
+}
+
+// GATHER_PRODUCTS()
+// Expands to the loops of gatherRow() that add, under ADD, the products
+// under MULTIPLY of row i of L with the rows of R into the accumulator. A
+// column the row meets for the first time starts from zero and joins the
+// touched columns. Private.
+#define GATHER_PRODUCTS(ADD, MULTIPLY)                                     \
+   for( int k = startL[i]; k < startL[i + 1]; k++ )                       \
+   {                                                                      \
+      int j = columnsL[k];                                                \
+      double a = valuesL[k];                                              \
+                                                                          \
+      for( int m = startR[j]; m < startR[j + 1]; m++ )                    \
+      {                                                                   \
+         int column = columnsR[m];                                        \
+         double* sum;                                                     \
+                                                                          \
+         if( isDense )                                                    \
+         {                                                                \
+            if( pA->marker[column] != pA->stamp )                         \
+            {                                                             \
+               pA->marker[column] = pA->stamp;                            \
+               pA->dense[column] = zero;                                  \
+               pA->touched[count++] = column;                             \
+            }                                                             \
+            sum = &(pA->dense[column]);                                   \
+         }                                                                \
+         else                                                             \
+         {                                                                \
+            unsigned slot = ((unsigned)column * 2654435761u) & mask;      \
+            while( pA->keys[slot] != 0 && pA->keys[slot] != column )      \
+            {                                                             \
+               slot = (slot + 1) & mask;                                  \
+            }                                                             \
+            if( pA->keys[slot] == 0 )                                     \
+            {                                                             \
+               pA->keys[slot] = column;                                   \
+               pA->sums[slot] = zero;                                     \
+               pA->touched[count++] = column;                             \
+            }                                                             \
+            sum = &(pA->sums[slot]);                                      \
+         }                                                                \
+         if( columns != NULL )                                            \
+         {                                                                \
+            *sum = ADD(*sum, MULTIPLY(a, valuesR[m]));                    \
+         }                                                                \
+      }                                                                   \
+   }
+
+// gatherRow()
+// Gathers row i of the product L R under semiring, whose arrays are laid
+// out as matrixToArrays() does, into *pA. With columns NULL only counts the
+// columns the row touches, which bounds its entries. Otherwise writes the
+// entries of the row to columns and values in column order and returns how
+// many there are. Under (+, x) the sums that come to 0.0 are left out.
+// Private.
+int gatherRow(RowAccumulator* pA, int i, const int* startL,
+              const int* columnsL, const double* valuesL, const int* startR,
+              const int* columnsR, const double* valuesR, int semiring,
+              int* columns, double* values)
+{
+   double zero = semiringZero(semiring);
+
+   long long bound = 0;
+   int count = 0, kept = 0, mask = 0, needed;
+   bool isDense;
+
+   for( int k = startL[i]; k < startL[i + 1]; k++ )
+   {
+      bound += startR[columnsL[k] + 1] - startR[columnsL[k]];
+   }
+   if( bound == 0 )
+   {
+      return 0;
+   }
+   needed = bound < pA->n ? (int)bound : pA->n;
+   if( needed > pA->touchedCapacity )
+   {
+      pA->touchedCapacity = needed;
+      pA->touched = realloc(pA->touched, needed * sizeof(int));
+   }
+   isDense = bound * DENSE_ROW_FRACTION >= pA->n;
+   if( isDense )
+   {
+      if( pA->marker == NULL )
+      {
+         pA->marker = calloc(pA->n + 1, sizeof(int));
+         pA->dense = malloc((pA->n + 1) * sizeof(double));
+      }
+      pA->stamp++;
+   }
+   else
+   {
+      int capacity = 16;
+      while( capacity < 2 * bound )
+      {
+         capacity *= 2;
+      }
+      if( capacity > pA->capacity )
+      {
+         free(pA->keys);
+         free(pA->sums);
+         pA->keys = calloc(capacity, sizeof(int));
+         pA->sums = malloc(capacity * sizeof(double));
+         pA->capacity = capacity;
+      }
+      mask = capacity - 1;
+   }
+
+   // One copy of the loops per semiring, so the operations are inlined.
+   if( semiring == SEMIRING_MIN_PLUS )
+   {
+      GATHER_PRODUCTS(ADD_MIN, MULTIPLY_PLUS)
+   }
+   else if( semiring == SEMIRING_OR_AND )
+   {
+      GATHER_PRODUCTS(ADD_OR, MULTIPLY_AND)
+   }
+   else
+   {
+      GATHER_PRODUCTS(ADD_PLUS, MULTIPLY_TIMES)
+   }
+   if( columns == NULL )
+   {
+      kept = count;
+   }
+   else
+   {
+      qsort(pA->touched, count, sizeof(int), compareColumns);
+      for( int t = 0; t < count; t++ )
+      {
+         int column = pA->touched[t];
+         double sum;
+
+         if( isDense )
+         {
+            sum = pA->dense[column];
+         }
+         else
+         {
+            unsigned slot = ((unsigned)column * 2654435761u) & mask;
+            while( pA->keys[slot] != column )
+            {
+               slot = (slot + 1) & mask;
+            }
+            sum = pA->sums[slot];
+         }
+         if( sum != 0.0 || semiring != SEMIRING_PLUS_TIMES )
+         {
+            columns[kept] = column;
+            values[kept++] = sum;
+         }
+      }
+   }
+   if( !isDense )
+   {
+      // The table is at most four times the work just done for the row.
+      memset(pA->keys, 0, (mask + 1) * sizeof(int));
+   }
+   return kept;
+}
+
+// multCompressed()
+// Returns the compressed product L R under semiring by Gustavson's method:
+// row i is the sum of the rows of R picked by the entries of row i of L. A
+// symbolic pass bounds the entries of every row to size the output, then a
+// numeric pass fills it. Both split the rows among threads. Private.
+Matrix multCompressed(Matrix L, Matrix R, int semiring)
+{
+   int n = L->dimensions;
+   int *startL, *columnsL, *startR, *columnsR;
+   double *valuesL, *valuesR;
+   bool isCopyL = borrowRowArrays(L, &startL, &columnsL, &valuesL);
+   bool isCopyR = borrowRowArrays(R, &startR, &columnsR, &valuesR);
+   int* rowCount = malloc((n + 2) * sizeof(int));
+   int* bound = malloc((n + 2) * sizeof(int));
+   int* columns;
+   double* values;
+   Matrix P;
+
+   #pragma omp parallel
+   {
+      RowAccumulator A = newRowAccumulator(n);
+
+      #pragma omp for schedule(dynamic, 64)
+      for( int i = 1; i <= n; i++ )
+      {
+         rowCount[i] = gatherRow(&A, i, startL, columnsL, valuesL, startR,
+                                 columnsR, valuesR, semiring, NULL, NULL);
+      }
+      freeRowAccumulator(&A);
+   }
+   bound[0] = bound[1] = 0;
+   for( int i = 1; i <= n; i++ )
+   {
+      bound[i + 1] = bound[i] + rowCount[i];
+   }
+   columns = malloc((bound[n + 1] + 1) * sizeof(int));
+   values = malloc((bound[n + 1] + 1) * sizeof(double));
+
+   #pragma omp parallel
+   {
+      RowAccumulator A = newRowAccumulator(n);
+
+      #pragma omp for schedule(dynamic, 64)
+      for( int i = 1; i <= n; i++ )
+      {
+         rowCount[i] = gatherRow(&A, i, startL, columnsL, valuesL, startR,
+                                 columnsR, valuesR, semiring,
+                                 columns + bound[i], values + bound[i]);
+      }
+      freeRowAccumulator(&A);
+   }
+
+   // Sums that cancelled to zero leave gaps, closed up while copying.
+   int nnz = 0;
+   for( int i = 1; i <= n; i++ )
+   {
+      nnz += rowCount[i];
+   }
+   P = newCompressedMatrix(n, nnz);
+   for( int i = 1; i <= n; i++ )
+   {
+      P->rowStart[i + 1] = P->rowStart[i] + rowCount[i];
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      memcpy(P->columns + P->rowStart[i], columns + bound[i],
+             rowCount[i] * sizeof(int));
+      memcpy(P->values + P->rowStart[i], values + bound[i],
+             rowCount[i] * sizeof(double));
+   }
+
+   free(rowCount);
+   free(bound);
+   free(columns);
+   free(values);
+   returnRowArrays(isCopyL, startL, columnsL, valuesL);
+   returnRowArrays(isCopyR, startR, columnsR, valuesR);
+   return P;
+}
+
+// mult()
+// Returns a new Matrix that is the product of this Matrix with M, built by
+// multCompressed() and expanded back to lists unless an argument is
+// compressed.
+// pre: getMatrixSize()==M.getMatrixSize()
+Matrix mult(Matrix L, Matrix R)
+{
+   if( getMatrixSize(L) != getMatrixSize(R) )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition: mult()"
+             " called with mismatching dimensions.");
+      exit(1);
+   }
+   Matrix resultMatrix = multCompressed(L, R, SEMIRING_PLUS_TIMES);
+
+   if( !L->isCompressed && !R->isCompressed )
+   {
+      expandMatrix(resultMatrix);
+   }
+   return resultMatrix;
+}
+
+// checkSemiring()
+// Exits with an error naming caller unless semiring is one of the
+// SEMIRING_ constants. Private.
+void checkSemiring(int semiring, const char* caller)
+{
+   if( semiring != SEMIRING_PLUS_TIMES && semiring != SEMIRING_MIN_PLUS
+       && semiring != SEMIRING_OR_AND )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition: %s()"
+             " called with an unknown semiring.", caller);
+      exit(1);
+   }
+}
+
+// semiringMult()
+// Returns a new Matrix that is the product L R under semiring, computed as
+// mult() does and in the same storage mode.
+// pre: getMatrixSize(L)==getMatrixSize(R)
+Matrix semiringMult(Matrix L, Matrix R, int semiring)
+{
+   if( getMatrixSize(L) != getMatrixSize(R) )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " semiringMult() called with mismatching dimensions.");
+      exit(1);
+   }
+   checkSemiring(semiring, "semiringMult");
+   Matrix resultMatrix = multCompressed(L, R, semiring);
+
+   if( !L->isCompressed && !R->isCompressed )
+   {
+      expandMatrix(resultMatrix);
+   }
+   return resultMatrix;
+}
+
+// semiringAddRows()
+// Merges the sorted rows a and b under the addition of semiring, which
+// keeps every entry, and returns its length. The merged row is stored in
+// columns and values unless they are NULL. Private.
+int semiringAddRows(const int* columnsA, const double* valuesA, int countA,
+                    const int* columnsB, const double* valuesB, int countB,
+                    int semiring, int* columns, double* values)
+{
+   int a = 0, b = 0, count = 0;
+
+   while( a < countA || b < countB )
+   {
+      int column;
+      double data;
+
+      if( b == countB || ( a < countA && columnsA[a] < columnsB[b] ) )
+      {
+         column = columnsA[a];
+         data = valuesA[a++];
+      }
+      else if( a == countA || columnsB[b] < columnsA[a] )
+      {
+         column = columnsB[b];
+         data = valuesB[b++];
+      }
+      else
+      {
+         column = columnsA[a];
+         data = (semiring == SEMIRING_MIN_PLUS)
+                ? ADD_MIN(valuesA[a], valuesB[b])
+                : ADD_OR(valuesA[a], valuesB[b]);
+         a++;
+         b++;
+      }
+      if( columns != NULL )
+      {
+         columns[count] = column;
+         values[count] = data;
+      }
+      count++;
+   }
+   return count;
+}
+
+// semiringSum()
+// Returns the compressed sum of the compressed L and R under the addition
+// of semiring, which is (min, +) or (OR, AND). Private.
+Matrix semiringSum(Matrix L, Matrix R, int semiring)
+{
+   int n = L->dimensions;
+   int* rowLength = malloc((n + 1) * sizeof(int));
+   int nnz = 0;
+   Matrix S;
+
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      rowLength[i] = semiringAddRows(L->columns + L->rowStart[i],
+                                     L->values + L->rowStart[i],
+                                     L->rowStart[i + 1] - L->rowStart[i],
+                                     R->columns + R->rowStart[i],
+                                     R->values + R->rowStart[i],
+                                     R->rowStart[i + 1] - R->rowStart[i],
+                                     semiring, NULL, NULL);
+   }
+   for( int i = 1; i <= n; i++ )
+   {
+      nnz += rowLength[i];
+   }
+   S = newCompressedMatrix(n, nnz);
+   for( int i = 1; i <= n; i++ )
+   {
+      S->rowStart[i + 1] = S->rowStart[i] + rowLength[i];
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      semiringAddRows(L->columns + L->rowStart[i], L->values + L->rowStart[i],
+                      L->rowStart[i + 1] - L->rowStart[i],
+                      R->columns + R->rowStart[i], R->values + R->rowStart[i],
+                      R->rowStart[i + 1] - R->rowStart[i], semiring,
+                      S->columns + S->rowStart[i], S->values + S->rowStart[i]);
+   }
+
+   free(rowLength);
+   return S;
+}
+
+// semiringClosure()
+// Returns the sum under semiring of M, M M, M M M, ... by repeated
+// squaring: C becomes C + C C until it stops changing, which takes about
+// log2(n) products. Under (min, +) entry (i, j) of the result is the length
+// of a shortest path of one arc or more from i to j, taking entry
+// (i, j) of M as the length of the arc from i to j, and under (OR, AND) it
+// is 1.0 if there is such a path. The result is in the same storage mode
+// as M.
+// pre: semiring is SEMIRING_MIN_PLUS, where M has no negative cycle, or
+// SEMIRING_OR_AND
+Matrix semiringClosure(Matrix M, int semiring)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling semiringClosure() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   if( semiring != SEMIRING_MIN_PLUS && semiring != SEMIRING_OR_AND )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " semiringClosure() called with a semiring other than"
+             " SEMIRING_MIN_PLUS or SEMIRING_OR_AND.");
+      exit(1);
+   }
+   Matrix C = copyMatrix(M);
+
+   compressMatrix(C);
+   if( semiring == SEMIRING_OR_AND )
+   {
+      for( int k = 0; k < C->rowStart[C->dimensions + 1]; k++ )
+      {
+         C->values[k] = 1.0;
+      }
+   }
+   // Paths of up to 2^k arcs after k steps, so n steps always suffice;
+   // more only happen with a negative cycle.
+   for( long long reach = 1; reach < 2LL * C->dimensions; reach *= 2 )
+   {
+      Matrix P = multCompressed(C, C, semiring);
+      Matrix S = semiringSum(C, P, semiring);
+      bool isStable = areMatricesEqual(C, S);
+
+      freeMatrix(&P);
+      freeMatrix(&C);
+      C = S;
+      if( isStable )
+      {
+         break;
+      }
+   }
+   if( !M->isCompressed )
+   {
+      expandMatrix(C);
+   }
+   return C;
+}
+
+// permuteMatrix()
+// returns a new Matrix where row and column i of M become row and column
+// newLabel[i], in the same storage mode as M.
+// pre: newLabel[1..getMatrixSize()] is a permutation of 1..getMatrixSize()
+Matrix permuteMatrix(Matrix M, int* newLabel)
+{
+   if( M == NULL || newLabel == NULL )
+   {
+      printf("Matrix error: calling permuteMatrix() on NULL Matrix or label"
+             " reference.\n");
+      exit(1);
+   }
+   int n = M->dimensions;
+   int *rowStart, *columns;
+   double* values;
+   Matrix permutedMatrix;
+
+   if( M->isCompressed )
+   {
+      int nnz = M->rowStart[n + 1];
+      int* rows = malloc((nnz + 1) * sizeof(int));
+      int* renamed = malloc((nnz + 1) * sizeof(int));
+
+      for( int i = 1; i <= n; i++ )
+      {
+         for( int k = M->rowStart[i]; k < M->rowStart[i + 1]; k++ )
+         {
+            rows[k] = newLabel[i];
+            renamed[k] = newLabel[M->columns[k]];
+         }
+      }
+      permutedMatrix = buildCompressedMatrix(n, rows, renamed, M->values,
+                                             nnz);
+      free(rows);
+      free(renamed);
+      return permutedMatrix;
+   }
+   permutedMatrix = newMatrix(n);
+   matrixToArrays(M, &rowStart, &columns, &values);
+   EntryObj* row = malloc((rowStart[n + 1] + 1) * sizeof(EntryObj));
+
+   for( int i = 1; i <= n; i++ )
+   {
+      int count = rowStart[i + 1] - rowStart[i];
+      EntryObj* renamed = row + rowStart[i];
+
+      for( int k = 0; k < count; k++ )
+      {
+         renamed[k].columnNumber = newLabel[columns[rowStart[i] + k]];
+         renamed[k].data = values[rowStart[i] + k];
+      }
+      qsort(renamed, count, sizeof(EntryObj), compareEntries);
+      for( int k = 0; k < count; k++ )
+      {
+         appendEntry(permutedMatrix->rows[newLabel[i]], renamed[k].columnNumber,
+                     renamed[k].data);
+      }
+   }
+
+   free(rowStart);
+   free(columns);
+   free(values);
+   free(row);
+   return permutedMatrix;
+}
+
+// Other Functions ---------------------------------------------------------
+
+// writeMatrixRows()
+// writes the matrixToString() lines of rows first to last to W. Private.
+void writeMatrixRows(BufferedWriter W, Matrix M, int first, int last)
+{
+   for( int i = first; i <= last; i++ )
+   {
+      writeInt(W, i);
+      writeChar(W, ':');
+      for( RowIterator I = rowBegin(M, i); !rowAtEnd(I); rowNext(&I) )
+      {
+         writeChar(W, '(');
+         writeInt(W, rowColumn(I));
+         writeText(W, ", ");
+         writeDouble(W, rowData(I));
+         writeText(W, ") ");
+      }
+      writeChar(W, '\n');
+   }
+}
+
+// matrixToString()
+// writes a text representation of the matrix to out, one "i:(j, x) ..."
+// line per row, through a large buffer.
+void matrixToString(FILE * out, Matrix M)
+{
+   BufferedWriter W = newBufferedWriter(out, DEFAULT_WRITER_CAPACITY);
+   writeMatrixRows(W, M, 1, M->dimensions);
+   freeBufferedWriter(&W);
+}
+
+// writeMatrixSegments()
+// writes the lines of matrixToString() to segmentCount files named
+// pathPrefix.0, pathPrefix.1, ... in parallel, splitting the rows into
+// ranges of about the same output size. Concatenated in order, the files
+// hold exactly what matrixToString() writes. Returns false if a file could
+// not be written.
+bool writeMatrixSegments(Matrix M, const char* pathPrefix, int segmentCount)
+{
+   if( M == NULL || pathPrefix == NULL )
+   {
+      printf("Matrix error: calling writeMatrixSegments() on NULL Matrix or"
+             " path reference.\n");
+      exit(1);
+   }
+   if( segmentCount < 1 )
+   {
+      printf("Matrix error: calling writeMatrixSegments() with fewer than"
+             " one segment.\n");
+      exit(1);
+   }
+   int n = M->dimensions;
+   int* firstRow = malloc((segmentCount + 1) * sizeof(int));
+   long long total = 0, written = 0;
+   bool isWritten = true;
+
+   // A line costs about one unit per entry plus one for the row number.
+   for( int i = 1; i <= n; i++ )
+   {
+      total += rowLength(M, i) + 1;
+   }
+   firstRow[0] = 1;
+   for( int i = 1, k = 1; k < segmentCount; k++ )
+   {
+      while( i <= n && written < total * k / segmentCount )
+      {
+         written += rowLength(M, i++) + 1;
+      }
+      firstRow[k] = i;
+   }
+   firstRow[segmentCount] = n + 1;
+
+   #pragma omp parallel for schedule(dynamic, 1) reduction(&&:isWritten)
+   for( int k = 0; k < segmentCount; k++ )
+   {
+      size_t pathLength = strlen(pathPrefix) + 16;
+      char* path = malloc(pathLength);
+      FILE* out;
+
+      snprintf(path, pathLength, "%s.%d", pathPrefix, k);
+      out = fopen(path, "w");
+      if( out == NULL )
+      {
+         isWritten = false;
+      }
+      else
+      {
+         BufferedWriter W = newBufferedWriter(out, DEFAULT_WRITER_CAPACITY);
+         writeMatrixRows(W, M, firstRow[k], firstRow[k + 1] - 1);
+         isWritten = flushWriter(W) && isWritten;
+         freeBufferedWriter(&W);
+         isWritten = (fclose(out) == 0) && isWritten;
+      }
+      free(path);
+   }
+
+   free(firstRow);
+   return isWritten;
+}
+
+// dot()
+// Takes the dot product of two lists.
+double dot(List P, List Q)
+{
+   double returnValue = 0;
+   
+   int columnP = 0, columnQ = 0;
+   ListIterator I = listBegin(P);
+   ListIterator J = listBegin(Q);
+
+   while( !listAtEnd(I) && !listAtEnd(J) )
+   {
+      columnP = iteratorColumn(I);
+      columnQ = iteratorColumn(J);
+
+      if( columnP == columnQ )
+      {
+         returnValue += iteratorData(I) * iteratorData(J);
+         iteratorNext(&I);
+         iteratorNext(&J);
+      }
+      else if( columnP < columnQ )
+      {
+         iteratorNext(&I);
+      }
+      else  /* columnQ < columnP */
+      {
+         iteratorNext(&J);
+      }
+   }
+   return returnValue; 
+}
+
+// rowTimesVector()
+// Returns the dot product of the count entries in columns and values with
+// x, four entries at a time with AVX2 gathers and fused multiply adds when
+// the processor has them. Private.
+double rowTimesVector(const int* columns, const double* values, int count,
+                      const double* x)
+{
+   double sum = 0.0;
+   int k = 0;
+
+#ifdef AVX2_KERNELS
+   if( count >= 4 && hasAvx2() )
+   {
+      k = rowTimesVectorAvx2(columns, values, count, x, &sum);
+   }
+#endif
+   for( ; k < count; k++ )
+   {
+      sum += values[k] * x[columns[k]];
+   }
+   return sum;
+}
+
+// spmv()
+// Sets y[1..n] to M x[1..n], where n is the size of M. Rows are split among
+// threads in ranges holding about the same number of entries. A Matrix
+// that is not compressed is copied into arrays on every call, so compress
+// M first to multiply it many times. x and y must not overlap.
+void spmv(Matrix M, const double* x, double* y)
+{
+   if( M == NULL || x == NULL || y == NULL )
+   {
+      printf("Matrix error: calling spmv() on NULL Matrix or vector"
+             " reference.\n");
+      exit(1);
+   }
+   int *rowStart, *columns;
+   double* values;
+   bool isCopy = borrowRowArrays(M, &rowStart, &columns, &values);
+
+   arraysTimesVector(M->dimensions, rowStart, columns, values, x, y);
+   returnRowArrays(isCopy, rowStart, columns, values);
+}
+
+// SEMIRING_ROWS()
+// Expands to the loop of semiringSpmv() that sets y[i] to the sum under
+// ADD of the products under MULTIPLY of row i with x, for the rows of
+// range p. Private.
+#define SEMIRING_ROWS(ADD, MULTIPLY)                                       \
+   for( int i = firstRow[p]; i < firstRow[p + 1]; i++ )                   \
+   {                                                                      \
+      double sum = zero;                                                  \
+      for( int k = rowStart[i]; k < rowStart[i + 1]; k++ )                \
+      {                                                                   \
+         sum = ADD(sum, MULTIPLY(values[k], x[columns[k]]));              \
+      }                                                                   \
+      y[i] = sum;                                                         \
+   }
+
+// semiringSpmv()
+// Sets y[1..n] to M x[1..n] under semiring, one of the SEMIRING_
+// constants, under the same terms as spmv(). A row with no entries gives
+// the zero of the semiring: 0.0, or INFINITY under (min, +).
+void semiringSpmv(Matrix M, const double* x, double* y, int semiring)
+{
+   if( M == NULL || x == NULL || y == NULL )
+   {
+      printf("Matrix error: calling semiringSpmv() on NULL Matrix or vector"
+             " reference.\n");
+      exit(1);
+   }
+   checkSemiring(semiring, "semiringSpmv");
+   if( semiring == SEMIRING_PLUS_TIMES )
+   {
+      spmv(M, x, y);
+      return;
+   }
+   int n = M->dimensions;
+   int *rowStart, *columns;
+   double* values;
+   bool isCopy = borrowRowArrays(M, &rowStart, &columns, &values);
+   double zero = semiringZero(semiring);
+   int parts = 1;
+
+#ifdef _OPENMP
+   parts = omp_get_max_threads();
+#endif
+   int* firstRow = malloc((parts + 1) * sizeof(int));
+
+   splitRowsByEntries(n, rowStart, parts, firstRow);
+   #pragma omp parallel for schedule(static, 1)
+   for( int p = 0; p < parts; p++ )
+   {
+      if( semiring == SEMIRING_MIN_PLUS )
+      {
+         SEMIRING_ROWS(ADD_MIN, MULTIPLY_PLUS)
+      }
+      else
+      {
+         SEMIRING_ROWS(ADD_OR, MULTIPLY_AND)
+      }
+   }
+
+   free(firstRow);
+   returnRowArrays(isCopy, rowStart, columns, values);
+}
+
+// spmvT()
+// Sets y[1..n] to the transpose of M times x[1..n], under the same terms
+// as spmv(). On one thread the rows of M are scattered into y. On more,
+// the first call builds the compressed transpose of M and keeps it with M
+// until M changes, so later calls run as fast as spmv().
+void spmvT(Matrix M, const double* x, double* y)
+{
+   if( M == NULL || x == NULL || y == NULL )
+   {
+      printf("Matrix error: calling spmvT() on NULL Matrix or vector"
+             " reference.\n");
+      exit(1);
+   }
+   int n = M->dimensions;
+   int *rowStart, *columns;
+   double* values;
+   bool isCopy;
+
+#ifdef _OPENMP
+   if( omp_get_max_threads() > 1 )
+   {
+      // Scattering rows from several threads would need atomic adds or a
+      // copy of y per thread, so multiply by the kept transpose instead.
+      if( M->transposed == NULL )
+      {
+         isCopy = borrowRowArrays(M, &rowStart, &columns, &values);
+         M->transposed = transposeArrays(n, rowStart, columns, values);
+         returnRowArrays(isCopy, rowStart, columns, values);
+      }
+      spmv(M->transposed, x, y);
+      return;
+   }
+#endif
+   // Row i of M scatters x[i] times its entries into y.
+   isCopy = borrowRowArrays(M, &rowStart, &columns, &values);
+   memset(y + 1, 0, n * sizeof(double));
+   for( int i = 1; i <= n; i++ )
+   {
+      for( int k = rowStart[i]; k < rowStart[i + 1]; k++ )
+      {
+         y[columns[k]] += values[k] * x[i];
+      }
+   }
+   returnRowArrays(isCopy, rowStart, columns, values);
+}
+
+// powerIteration()
+// Runs the power method on M starting from x[1..n], where n is the size of
+// M, and leaves in x the dominant eigenvector scaled to unit length. Stops
+// once an iteration changes x by less than tolerance (in the 1-norm) or
+// after maxIterations. Stores the eigenvalue estimate in *pEigenvalue if it
+// is not NULL. Returns the number of iterations.
+int powerIteration(Matrix M, double* x, double tolerance, int maxIterations,
+                   double* pEigenvalue)
+{
+   if( M == NULL || x == NULL )
+   {
+      printf("Matrix error: calling powerIteration() on NULL Matrix or"
+             " vector reference.\n");
+      exit(1);
+   }
+   int n = M->dimensions;
+   Matrix A = M;
+   double* y = malloc((n + 1) * sizeof(double));
+   double norm = 0.0, eigenvalue = 0.0;
+   int iterations = 0;
+
+   if( !M->isCompressed )
+   {
+      A = copyMatrix(M);
+      compressMatrix(A);
+   }
+
+   for( int i = 1; i <= n; i++ )
+   {
+      norm += x[i] * x[i];
+   }
+   if( norm == 0.0 )
+   {
+      for( int i = 1; i <= n; i++ )
+      {
+         x[i] = 1.0;
+      }
+      norm = n;
+   }
+   norm = sqrt(norm);
+   for( int i = 1; i <= n; i++ )
+   {
+      x[i] /= norm;
+   }
+
+   while( iterations < maxIterations )
+   {
+      double change = 0.0;
+
+      spmv(A, x, y);
+      iterations++;
+
+      // With x of unit length, x.y is the Rayleigh quotient.
+      norm = 0.0;
+      eigenvalue = 0.0;
+      #pragma omp parallel for reduction(+:norm, eigenvalue)
+      for( int i = 1; i <= n; i++ )
+      {
+         norm += y[i] * y[i];
+         eigenvalue += x[i] * y[i];
+      }
+      if( norm == 0.0 )
+      {
+         break;
+      }
+      norm = sqrt(norm);
+
+      #pragma omp parallel for reduction(+:change)
+      for( int i = 1; i <= n; i++ )
+      {
+         y[i] /= norm;
+         change += fabs(y[i] - x[i]);
+         x[i] = y[i];
+      }
+      if( change < tolerance )
+      {
+         break;
+      }
+   }
+   if( pEigenvalue != NULL )
+   {
+      *pEigenvalue = eigenvalue;
+   }
+
+   if( A != M )
+   {
+      freeMatrix(&A);
+   }
+   free(y);
+   return iterations;
+}
+
+// timesVectorDot()
+// Sets q to A p, where A is stored in rowStart, columns and values as
+// matrixToArrays() lays it out, and returns p.q from the same pass. The
+// rows are the parts ranges laid out by firstRow, one per thread. Private.
+double timesVectorDot(const int* rowStart, const int* columns,
+                      const double* values, const int* firstRow, int parts,
+                      const double* p, double* q)
+{
+   double pq = 0.0;
+
+   #pragma omp parallel for schedule(static, 1) reduction(+:pq)
+   for( int part = 0; part < parts; part++ )
+   {
+      for( int i = firstRow[part]; i < firstRow[part + 1]; i++ )
+      {
+         q[i] = rowTimesVector(columns + rowStart[i], values + rowStart[i],
+                               rowStart[i + 1] - rowStart[i], p);
+         pq += p[i] * q[i];
+      }
+   }
+   return pq;
+}
+
+// diagonalOf()
+// Returns the entry on the diagonal of row i of the arrays, or 0.0.
+// Private.
+double diagonalOf(int i, const int* rowStart, const int* columns,
+                  const double* values)
+{
+   for( int k = rowStart[i]; k < rowStart[i + 1]; k++ )
+   {
+      if( columns[k] == i )
+      {
+         return values[k];
+      }
+   }
+   return 0.0;
+}
+
+// incompleteCholesky()
+// Computes the lower triangular L with the pattern of the lower triangle
+// of the symmetric matrix in the arrays, such that L L^T matches it on
+// that pattern. Row i of L holds its columns below the diagonal in
+// increasing order, then the diagonal last. A pivot that is not positive,
+// as in the last row of a graph Laplacian, is replaced by the square root
+// of the diagonal of the matrix. The caller frees the three arrays.
+// Private.
+void incompleteCholesky(int n, const int* rowStart, const int* columns,
+                        const double* values, int** pStartL,
+                        int** pColumnsL, double** pValuesL)
+{
+   int* startL = malloc((n + 2) * sizeof(int));
+   int *columnsL;
+   double* valuesL;
+
+   startL[0] = startL[1] = 0;
+   for( int i = 1; i <= n; i++ )
+   {
+      int count = 1;
+      for( int k = rowStart[i]; k < rowStart[i + 1]; k++ )
+      {
+         count += (columns[k] < i);
+      }
+      startL[i + 1] = startL[i] + count;
+   }
+   columnsL = malloc((startL[n + 1] + 1) * sizeof(int));
+   valuesL = malloc((startL[n + 1] + 1) * sizeof(double));
+
+   for( int i = 1; i <= n; i++ )
+   {
+      int last = startL[i + 1] - 1;
+      int m = startL[i];
+      double diagonal = 0.0, pivot;
+
+      for( int k = rowStart[i]; k < rowStart[i + 1]; k++ )
+      {
+         if( columns[k] < i )
+         {
+            columnsL[m] = columns[k];
+            valuesL[m++] = values[k];
+         }
+         else if( columns[k] == i )
+         {
+            diagonal = values[k];
+         }
+      }
+      // L[i][j] = (A[i][j] - sum of L[i][t] L[j][t] over t < j) / L[j][j],
+      // the sum running over the columns rows i and j of L share.
+      for( m = startL[i]; m < last; m++ )
+      {
+         int j = columnsL[m];
+         int a = startL[i], b = startL[j];
+         double sum = valuesL[m];
+
+         while( a < m && b < startL[j + 1] - 1 )
+         {
+            if( columnsL[a] < columnsL[b] )
+            {
+               a++;
+            }
+            else if( columnsL[b] < columnsL[a] )
+            {
+               b++;
+            }
+            else
+            {
+               sum -= valuesL[a++] * valuesL[b++];
+            }
+         }
+         valuesL[m] = sum / valuesL[startL[j + 1] - 1];
+      }
+      pivot = diagonal;
+      for( m = startL[i]; m < last; m++ )
+      {
+         pivot -= valuesL[m] * valuesL[m];
+      }
+      if( !(pivot > 1e-12 * fabs(diagonal)) )
+      {
+         pivot = (diagonal > 0.0) ? diagonal : 1.0;
+      }
+      columnsL[last] = i;
+      valuesL[last] = sqrt(pivot);
+   }
+   *pStartL = startL;
+   *pColumnsL = columnsL;
+   *pValuesL = valuesL;
+}
+
+// choleskySolve()
+// Sets z[1..n] to (L L^T)^-1 r[1..n] for the L of incompleteCholesky(), by
+// a forward and a backward substitution. Private.
+void choleskySolve(int n, const int* startL, const int* columnsL,
+                   const double* valuesL, const double* r, double* z)
+{
+   for( int i = 1; i <= n; i++ )
+   {
+      double sum = r[i];
+      for( int k = startL[i]; k < startL[i + 1] - 1; k++ )
+      {
+         sum -= valuesL[k] * z[columnsL[k]];
+      }
+      z[i] = sum / valuesL[startL[i + 1] - 1];
+   }
+   // Row i of L is column i of L^T, so every solved z[i] is subtracted
+   // from the rows above it.
+   for( int i = n; i >= 1; i-- )
+   {
+      z[i] /= valuesL[startL[i + 1] - 1];
+      for( int k = startL[i]; k < startL[i + 1] - 1; k++ )
+      {
+         z[columnsL[k]] -= valuesL[k] * z[i];
+      }
+   }
+}
+
+// conjugateGradient()
+// Solves A x = b for the symmetric positive (semi)definite A by the
+// preconditioned conjugate gradient method, starting from the guess in
+// x[1..n] and leaving the solution there. preconditioner is one of the
+// PRECONDITION_ constants. Stops once the 2-norm of the residual b - A x is
+// at most tolerance times that of b, after maxIterations, or when callback
+// returns false; callback may be NULL. Stores that norm in *pResidual if
+// it is not NULL. Returns the number of iterations.
+int conjugateGradient(Matrix A, const double* b, double* x,
+                      int preconditioner, double tolerance,
+                      int maxIterations, ConjugateGradientCallback callback,
+                      void* data, double* pResidual)
+{
+   if( A == NULL || b == NULL || x == NULL )
+   {
+      printf("Matrix error: calling conjugateGradient() on NULL Matrix or"
+             " vector reference.\n");
+      exit(1);
+   }
+   if( preconditioner != PRECONDITION_NONE
+       && preconditioner != PRECONDITION_JACOBI
+       && preconditioner != PRECONDITION_INCOMPLETE_CHOLESKY )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " conjugateGradient() called with an unknown"
+             " preconditioner.");
+      exit(1);
+   }
+   int n = A->dimensions;
+   int *rowStart, *columns;
+   double* values;
+   bool isCopy = borrowRowArrays(A, &rowStart, &columns, &values);
+   double* r = malloc((n + 1) * sizeof(double));
+   double* z = malloc((n + 1) * sizeof(double));
+   double* p = malloc((n + 1) * sizeof(double));
+   double* q = malloc((n + 1) * sizeof(double));
+   double* inverseDiagonal = malloc((n + 1) * sizeof(double));
+   int *startL = NULL, *columnsL = NULL;
+   double* valuesL = NULL;
+   double bb = 0.0, rr = 0.0, rz = 0.0, goal;
+   int iterations = 0, parts = 1;
+
+#ifdef _OPENMP
+   parts = omp_get_max_threads();
+#endif
+   int* firstRow = malloc((parts + 1) * sizeof(int));
+
+   splitRowsByEntries(n, rowStart, parts, firstRow);
+   #pragma omp parallel for
+   for( int i = 1; i <= n; i++ )
+   {
+      double diagonal = diagonalOf(i, rowStart, columns, values);
+      inverseDiagonal[i] =
+         (preconditioner == PRECONDITION_JACOBI && diagonal != 0.0)
+         ? 1.0 / diagonal : 1.0;
+   }
+   if( preconditioner == PRECONDITION_INCOMPLETE_CHOLESKY )
+   {
+      incompleteCholesky(n, rowStart, columns, values, &startL, &columnsL,
+                         &valuesL);
+   }
+
+   // r = b - A x and z = M^-1 r, with their products, in one pass.
+   timesVectorDot(rowStart, columns, values, firstRow, parts, x, q);
+   #pragma omp parallel for reduction(+:bb, rr, rz)
+   for( int i = 1; i <= n; i++ )
+   {
+      r[i] = b[i] - q[i];
+      z[i] = inverseDiagonal[i] * r[i];
+      bb += b[i] * b[i];
+      rr += r[i] * r[i];
+      rz += r[i] * z[i];
+   }
+   if( startL != NULL )
+   {
+      choleskySolve(n, startL, columnsL, valuesL, r, z);
+      rz = 0.0;
+      #pragma omp parallel for reduction(+:rz)
+      for( int i = 1; i <= n; i++ )
+      {
+         rz += r[i] * z[i];
+      }
+   }
+   memcpy(p + 1, z + 1, n * sizeof(double));
+   goal = tolerance * sqrt(bb);
+
+   while( iterations < maxIterations && sqrt(rr) > goal )
+   {
+      double pq = timesVectorDot(rowStart, columns, values, firstRow, parts,
+                                 p, q);
+      double alpha, beta, rzNext = 0.0;
+
+      if( pq == 0.0 )
+      {
+         break;
+      }
+      alpha = rz / pq;
+      iterations++;
+
+      // Step x and r, precondition r and take the products in one pass.
+      rr = 0.0;
+      #pragma omp parallel for reduction(+:rr, rzNext)
+      for( int i = 1; i <= n; i++ )
+      {
+         x[i] += alpha * p[i];
+         r[i] -= alpha * q[i];
+         z[i] = inverseDiagonal[i] * r[i];
+         rr += r[i] * r[i];
+         rzNext += r[i] * z[i];
+      }
+      if( callback != NULL && !callback(iterations, sqrt(rr), data) )
+      {
+         break;
+      }
+      if( sqrt(rr) <= goal )
+      {
+         break;
+      }
+      if( startL != NULL )
+      {
+         choleskySolve(n, startL, columnsL, valuesL, r, z);
+         rzNext = 0.0;
+         #pragma omp parallel for reduction(+:rzNext)
+         for( int i = 1; i <= n; i++ )
+         {
+            rzNext += r[i] * z[i];
+         }
+      }
+      beta = rzNext / rz;
+      rz = rzNext;
+      #pragma omp parallel for
+      for( int i = 1; i <= n; i++ )
+      {
+         p[i] = z[i] + beta * p[i];
+      }
+   }
+   if( pResidual != NULL )
+   {
+      *pResidual = sqrt(rr);
+   }
+
+   free(r);
+   free(z);
+   free(p);
+   free(q);
+   free(inverseDiagonal);
+   free(firstRow);
+   free(startL);
+   free(columnsL);
+   free(valuesL);
+   returnRowArrays(isCopy, rowStart, columns, values);
+   return iterations;
+}
+   
+// Helper Functions --------------------------------------------------------
+
+// addHelper()
+// helper functions for add(). Returns a new List holding a + b, or a - b if
+// isSum is false.
+List addHelper(List a, List b, bool isSum)
+{
+   List resultList = newList();
+   double sign = isSum ? 1.0 : -1.0;
+   double data;
+   ListIterator I = listBegin(a);
+   ListIterator J = listBegin(b);
+
+   while( !listAtEnd(I) || !listAtEnd(J) )
+   {
+      if( listAtEnd(J)
+          || ( !listAtEnd(I) && iteratorColumn(I) < iteratorColumn(J) ) )
+      {
+         appendEntry(resultList, iteratorColumn(I), iteratorData(I));
+         iteratorNext(&I);
+      }
+      else if( listAtEnd(I) || iteratorColumn(J) < iteratorColumn(I) )
+      {
+         appendEntry(resultList, iteratorColumn(J), sign * iteratorData(J));
+         iteratorNext(&J);
+      }
+      else
+      {
+         data = iteratorData(I) + sign * iteratorData(J);
+         if( data != 0.0 )
+         {
+            appendEntry(resultList, iteratorColumn(I), data);
+         }
+         iteratorNext(&I);
+         iteratorNext(&J);
+      }
+   }
+   return resultList;
+}
+
+// matrixToArrays()
+// Copies the rows of M into contiguous arrays. Row i holds the entries
+// (*pColumns)[k], (*pValues)[k] for (*pRowStart)[i] <= k < (*pRowStart)[i + 1].
+// The caller frees the three arrays.
+void matrixToArrays(Matrix M, int** pRowStart, int** pColumns,
+                    double** pValues)
+{
+   int n = M->dimensions;
+   int* rowStart = malloc((n + 2) * sizeof(int));
+   int* columns;
+   double* values;
+
+   if( M->isCompressed )
+   {
+      int nnz = M->rowStart[n + 1];
+
+      columns = malloc((nnz + 1) * sizeof(int));
+      values = malloc((nnz + 1) * sizeof(double));
+      memcpy(rowStart, M->rowStart, (n + 2) * sizeof(int));
+      memcpy(columns, M->columns, nnz * sizeof(int));
+      memcpy(values, M->values, nnz * sizeof(double));
+      *pRowStart = rowStart;
+      *pColumns = columns;
+      *pValues = values;
+      return;
+   }
+   rowStart[0] = rowStart[1] = 0;
+   for( int i = 1; i <= n; i++ )
+   {
+      rowStart[i + 1] = rowStart[i] + length(M->rows[i]);
+   }
+   columns = malloc((rowStart[n + 1] + 1) * sizeof(int));
+   values = malloc((rowStart[n + 1] + 1) * sizeof(double));
+
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int i = 1; i <= n; i++ )
+   {
+      int k = rowStart[i];
+      for( ListIterator I = listBegin(M->rows[i]); !listAtEnd(I);
+           iteratorNext(&I) )
+      {
+         columns[k] = iteratorColumn(I);
+         values[k] = iteratorData(I);
+         k++;
+      }
+   }
+   *pRowStart = rowStart;
+   *pColumns = columns;
+   *pValues = values;
+}
+
+// arraysTimesVector()
+// Sets y[1..n] to A x[1..n], where A is the n by n matrix stored in rowStart,
+// columns and values as matrixToArrays() lays it out. Rows are split among
+// threads in ranges holding about the same number of entries, so a few
+// dense rows do not leave the other threads idle.
+void arraysTimesVector(int n, int* rowStart, int* columns, double* values,
+                       const double* x, double* y)
+{
+   int parts = 1;
+
+#ifdef _OPENMP
+   parts = omp_get_max_threads();
+#endif
+   int* firstRow = malloc((parts + 1) * sizeof(int));
+
+   splitRowsByEntries(n, rowStart, parts, firstRow);
+   #pragma omp parallel for schedule(static, 1)
+   for( int p = 0; p < parts; p++ )
+   {
+      for( int i = firstRow[p]; i < firstRow[p + 1]; i++ )
+      {
+         y[i] = rowTimesVector(columns + rowStart[i], values + rowStart[i],
+                               rowStart[i + 1] - rowStart[i], x);
+      }
+   }
+   free(firstRow);
+}
+
+// End of Matrix ------------------------------------------------------------------
+
+// Matrix expression Definitions --------------------------------------------------
+
+#define EXPRESSION_MATRIX 1
+#define EXPRESSION_SCALE  2
+#define EXPRESSION_SUM    3
+
+// Struct -------------------------------------------------------------------------
+
+typedef struct MatrixExpressionObj
+{
+   int kind;
+   int dimensions;
+   Matrix matrix;           // EXPRESSION_MATRIX
+   double scale;            // EXPRESSION_SCALE, or the sign of right in a sum
+   MatrixExpression left;   // the only operand of EXPRESSION_SCALE
+   MatrixExpression right;
+} MatrixExpressionObj;
+
+// Contructors --------------------------------------------------------------------
+
+// newExpressionNode()
+// Returns a node of the given kind with no operands. Private.
+MatrixExpression newExpressionNode(int kind, int dimensions)
+{
+   MatrixExpression E = malloc(sizeof(MatrixExpressionObj));
+
+   countAllocation(sizeof(MatrixExpressionObj));
+   E->kind = kind;
+   E->dimensions = dimensions;
+   E->matrix = NULL;
+   E->scale = 1.0;
+   E->left = E->right = NULL;
+   return E;
+}
+
+// matrixTerm()
+// Returns an expression standing for M. M is read when the expression is
+// evaluated, not copied, so it must not be freed before then.
+MatrixExpression matrixTerm(Matrix M)
+{
+   if( M == NULL )
+   {
+      printf("Matrix Error: calling matrixTerm() on NULL Matrix"
+             " reference.\n");
+      exit(1);
+   }
+   MatrixExpression E = newExpressionNode(EXPRESSION_MATRIX, M->dimensions);
+
+   E->matrix = M;
+   return E;
+}
+
+// scaleExpression()
+// Returns the expression alpha E, which takes over E.
+MatrixExpression scaleExpression(double alpha, MatrixExpression E)
+{
+   if( E == NULL )
+   {
+      printf("Matrix Error: calling scaleExpression() on NULL"
+             " MatrixExpression reference.\n");
+      exit(1);
+   }
+   MatrixExpression S = newExpressionNode(EXPRESSION_SCALE, E->dimensions);
+
+   S->scale = alpha;
+   S->left = E;
+   return S;
+}
+
+// newSumExpression()
+// Returns the expression L + sign R, which takes over L and R. Private.
+MatrixExpression newSumExpression(MatrixExpression L, MatrixExpression R,
+                                  double sign, const char* caller)
+{
+   if( L == NULL || R == NULL )
+   {
+      printf("Matrix Error: calling %s() on NULL MatrixExpression"
+             " reference.\n", caller);
+      exit(1);
+   }
+   if( L->dimensions != R->dimensions )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition: %s()"
+             " called with mismatching dimensions.", caller);
+      exit(1);
+   }
+   MatrixExpression S = newExpressionNode(EXPRESSION_SUM, L->dimensions);
+
+   S->scale = sign;
+   S->left = L;
+   S->right = R;
+   return S;
+}
+
+// addExpressions()
+// Returns the expression L + R, which takes over L and R.
+// pre: L and R stand for matrices of the same size
+MatrixExpression addExpressions(MatrixExpression L, MatrixExpression R)
+{
+   return newSumExpression(L, R, 1.0, "addExpressions");
+}
+
+// subExpressions()
+// Returns the expression L - R, which takes over L and R.
+// pre: L and R stand for matrices of the same size
+MatrixExpression subExpressions(MatrixExpression L, MatrixExpression R)
+{
+   return newSumExpression(L, R, -1.0, "subExpressions");
+}
+
+// freeMatrixExpression()
+// Frees *pE and every expression it took over, but none of the matrices
+// they stand for, and sets *pE to NULL.
+void freeMatrixExpression(MatrixExpression* pE)
+{
+   if( pE != NULL && *pE != NULL )
+   {
+      freeMatrixExpression(&((*pE)->left));
+      freeMatrixExpression(&((*pE)->right));
+      countRelease(sizeof(MatrixExpressionObj));
+      free(*pE);
+      *pE = NULL;
+   }
+}
+
+// Other Functions ---------------------------------------------------------------
+
+// countTerms()
+// Returns the number of matrices E stands for, counting repeats. Private.
+int countTerms(MatrixExpression E)
+{
+   if( E->kind == EXPRESSION_MATRIX )
+   {
+      return 1;
+   }
+   return countTerms(E->left) + ( (E->right != NULL) ? countTerms(E->right)
+                                                       : 0 );
+}
+
+// collectTerms()
+// Writes E, scaled by coefficient, as a sum of matrices times
+// coefficients, adding the coefficients of a Matrix met more than once.
+// Returns the new number of terms. Private.
+int collectTerms(MatrixExpression E, double coefficient, Matrix* matrices,
+                 double* coefficients, int count)
+{
+   if( E->kind == EXPRESSION_SCALE )
+   {
+      return collectTerms(E->left, coefficient * E->scale, matrices,
+                          coefficients, count);
+   }
+   if( E->kind == EXPRESSION_SUM )
+   {
+      count = collectTerms(E->left, coefficient, matrices, coefficients,
+                           count);
+      return collectTerms(E->right, coefficient * E->scale, matrices,
+                          coefficients, count);
+   }
+   for( int t = 0; t < count; t++ )
+   {
+      if( matrices[t] == E->matrix )
+      {
+         coefficients[t] += coefficient;
+         return count;
+      }
+   }
+   matrices[count] = E->matrix;
+   coefficients[count] = coefficient;
+   return count + 1;
+}
+
+// mergeTerms()
+// Merges row i of the count terms into the row of coefficients[0]
+// matrices[0] + coefficients[1] matrices[1] + ..., leaving out entries
+// that cancel, and returns its length. The row is stored in columns and
+// values unless they are NULL. iterators has room for count RowIterators.
+// Expressions are short, so the smallest column is found by a plain scan.
+// Private.
+int mergeTerms(Matrix* matrices, const double* coefficients, int count,
+               int i, RowIterator* iterators, int* columns, double* values)
+{
+   int length = 0;
+
+   for( int t = 0; t < count; t++ )
+   {
+      iterators[t] = rowBegin(matrices[t], i);
+   }
+   while( true )
+   {
+      int column = 0;
+      double sum = 0.0;
+
+      for( int t = 0; t < count; t++ )
+      {
+         if( !rowAtEnd(iterators[t])
+             && ( column == 0 || rowColumn(iterators[t]) < column ) )
+         {
+            column = rowColumn(iterators[t]);
+         }
+      }
+      if( column == 0 )
+      {
+         return length;
+      }
+      for( int t = 0; t < count; t++ )
+      {
+         if( !rowAtEnd(iterators[t]) && rowColumn(iterators[t]) == column )
+         {
+            sum += coefficients[t] * rowData(iterators[t]);
+            rowNext(&iterators[t]);
+         }
+      }
+      if( sum != 0.0 )
+      {
+         if( columns != NULL )
+         {
+            columns[length] = column;
+            values[length] = sum;
+         }
+         length++;
+      }
+   }
+}
+
+// evaluateExpression()
+// Returns a new Matrix holding the value of E, built a row at a time by
+// one merge of the rows of every Matrix in E, so no intermediate Matrix is
+// made. The result is compressed if one of those matrices is. E is
+// unchanged.
+Matrix evaluateExpression(MatrixExpression E)
+{
+   if( E == NULL )
+   {
+      printf("Matrix Error: calling evaluateExpression() on NULL"
+             " MatrixExpression reference.\n");
+      exit(1);
+   }
+   int n = E->dimensions;
+   int leaves = countTerms(E);
+   Matrix* matrices = malloc(leaves * sizeof(Matrix));
+   double* coefficients = malloc(leaves * sizeof(double));
+   int count = collectTerms(E, 1.0, matrices, coefficients, 0);
+   int* rowLength = malloc((n + 1) * sizeof(int));
+   bool isCompressed = false;
+   int nnz = 0;
+   Matrix R;
+
+   for( int t = 0; t < count; t++ )
+   {
+      isCompressed = isCompressed || matrices[t]->isCompressed;
+   }
+   // Terms that cancelled, as in A - A, are left out of the merge.
+   int kept = 0;
+   for( int t = 0; t < count; t++ )
+   {
+      if( coefficients[t] != 0.0 )
+      {
+         matrices[kept] = matrices[t];
+         coefficients[kept++] = coefficients[t];
+      }
+   }
+   count = kept;
+
+   // One pass sizes every row and a second fills them, so the result is
+   // the only allocation that grows with the matrices.
+   #pragma omp parallel
+   {
+      RowIterator* iterators = malloc((count + 1) * sizeof(RowIterator));
+
+      #pragma omp for schedule(dynamic, 256)
+      for( int i = 1; i <= n; i++ )
+      {
+         rowLength[i] = mergeTerms(matrices, coefficients, count, i,
+                                   iterators, NULL, NULL);
+      }
+      free(iterators);
+   }
+   for( int i = 1; i <= n; i++ )
+   {
+      nnz += rowLength[i];
+   }
+   R = newCompressedMatrix(n, nnz);
+   for( int i = 1; i <= n; i++ )
+   {
+      R->rowStart[i + 1] = R->rowStart[i] + rowLength[i];
+   }
+   #pragma omp parallel
+   {
+      RowIterator* iterators = malloc((count + 1) * sizeof(RowIterator));
+
+      #pragma omp for schedule(dynamic, 256)
+      for( int i = 1; i <= n; i++ )
+      {
+         mergeTerms(matrices, coefficients, count, i, iterators,
+                    R->columns + R->rowStart[i], R->values + R->rowStart[i]);
+      }
+      free(iterators);
+   }
+
+   free(matrices);
+   free(coefficients);
+   free(rowLength);
+   if( !isCompressed )
+   {
+      expandMatrix(R);
+   }
+   return R;
+}
+
+// End of Matrix expression -------------------------------------------------------
+
+// Sparse vector Definitions ------------------------------------------------------
+
+// A frontier whose rows hold more than 1/PULL_FRACTION of the entries of A
+// makes maskedSpmspv() pull instead of push.
+#define PULL_FRACTION 14
+
+// Struct -------------------------------------------------------------------------
+
+typedef struct SparseVectorObj
+{
+   int dimension;
+   int count;
+   int capacity;
+   int* indices;
+   double* values;
+} SparseVectorObj;
+
+// Contructors --------------------------------------------------------------------
+
+// newSparseVector()
+// Returns an empty sparse vector of dimension n.
+// Precondition n >= 1.
+SparseVector newSparseVector(int n)
+{
+   if( n < 1 )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " newSparseVector() called with a bad dimension.");
+      exit(1);
+   }
+   SparseVector V = malloc(sizeof(SparseVectorObj));
+
+   V->dimension = n;
+   V->count = 0;
+   V->capacity = 16;
+   V->indices = malloc(V->capacity * sizeof(int));
+   V->values = malloc(V->capacity * sizeof(double));
+   countAllocation(sizeof(SparseVectorObj));
+   countAllocation(V->capacity * (sizeof(int) + sizeof(double)));
+   return V;
+}
+
+// freeSparseVector()
+// Frees *pV and sets *pV to NULL.
+void freeSparseVector(SparseVector* pV)
+{
+   if( pV != NULL && *pV != NULL )
+   {
+      countRelease(sizeof(SparseVectorObj));
+      countRelease((*pV)->capacity * (sizeof(int) + sizeof(double)));
+      free((*pV)->indices);
+      free((*pV)->values);
+      free(*pV);
+      *pV = NULL;
+   }
+}
+
+// Access Functions ---------------------------------------------------------------
+
+// getSparseVectorSize()
+// Returns the dimension of V.
+int getSparseVectorSize(SparseVector V)
+{
+   if( V == NULL )
+   {
+      printf("Matrix Error: calling getSparseVectorSize() on NULL"
+             " SparseVector reference.\n");
+      exit(1);
+   }
+   return V->dimension;
+}
+
+// getSparseVectorNNZ()
+// Returns the number of entries stored in V.
+int getSparseVectorNNZ(SparseVector V)
+{
+   if( V == NULL )
+   {
+      printf("Matrix Error: calling getSparseVectorNNZ() on NULL"
+             " SparseVector reference.\n");
+      exit(1);
+   }
+   return V->count;
+}
+
+// sparseVectorIndex()
+// Returns the index of the kth entry of V, counting from 0 in the order
+// the entries were stored.
+// Pre: 0 <= k < getSparseVectorNNZ(V)
+int sparseVectorIndex(SparseVector V, int k)
+{
+   if( V == NULL || k < 0 || k >= V->count )
+   {
+      printf("Matrix Error: calling sparseVectorIndex() on NULL"
+             " SparseVector reference or out of bounds entry.\n");
+      exit(1);
+   }
+   return V->indices[k];
+}
+
+// sparseVectorValue()
+// Returns the value of the kth entry of V.
+// Pre: 0 <= k < getSparseVectorNNZ(V)
+double sparseVectorValue(SparseVector V, int k)
+{
+   if( V == NULL || k < 0 || k >= V->count )
+   {
+      printf("Matrix Error: calling sparseVectorValue() on NULL"
+             " SparseVector reference or out of bounds entry.\n");
+      exit(1);
+   }
+   return V->values[k];
+}
+
+// Manipulation procedures --------------------------------------------------------
+
+// clearSparseVector()
+// Removes every entry of V, keeping its storage.
+void clearSparseVector(SparseVector V)
+{
+   if( V == NULL )
+   {
+      printf("Matrix Error: calling clearSparseVector() on NULL"
+             " SparseVector reference.\n");
+      exit(1);
+   }
+   V->count = 0;
+}
+
+// appendSparseVector()
+// Stores the entry (index, value) after the entries of V. Does not look
+// for an earlier entry at index.
+// Pre: 1 <= index <= getSparseVectorSize(V)
+void appendSparseVector(SparseVector V, int index, double value)
+{
+   if( V == NULL )
+   {
+      printf("Matrix Error: calling appendSparseVector() on NULL"
+             " SparseVector reference.\n");
+      exit(1);
+   }
+   if( index < 1 || index > V->dimension )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " appendSparseVector() called with an out of bounds index.");
+      exit(1);
+   }
+   if( V->count == V->capacity )
+   {
+      countAllocation(V->capacity * (sizeof(int) + sizeof(double)));
+      V->capacity *= 2;
+      V->indices = realloc(V->indices, V->capacity * sizeof(int));
+      V->values = realloc(V->values, V->capacity * sizeof(double));
+   }
+   V->indices[V->count] = index;
+   V->values[V->count++] = value;
+}
+
+// Other Functions ---------------------------------------------------------------
+
+// maskedSpmspv()
+// Sets y to the product of the transpose of A with x over the Boolean
+// semiring, masked by the complement of visited: j is put in y if it is
+// not visited and A has an entry (i, j) for some i in x, and is then
+// marked visited. The value stored for j is such an i. A sparse frontier
+// pushes through the rows of A picked by x, in the order of x, so i is the
+// first of them to reach j. When the rows of x hold more than 1/14 of the
+// entries of A and AT, the transpose of A, is not NULL, every unvisited j
+// pulls instead through row j of AT, stopping at the first i in x, which
+// is then the smallest; y is then in increasing order.
+// pre: A, AT, x and y have the same size, visited has room for 1..n
+void maskedSpmspv(Matrix A, Matrix AT, SparseVector x, bool* visited,
+                  SparseVector y)
+{
+   if( A == NULL || x == NULL || y == NULL || visited == NULL )
+   {
+      printf("Matrix Error: calling maskedSpmspv() on NULL reference.\n");
+      exit(1);
+   }
+   int n = A->dimensions;
+   long long frontierEntries = 0;
+
+   if( x->dimension != n || y->dimension != n
+       || ( AT != NULL && AT->dimensions != n ) )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " maskedSpmspv() called with mismatching dimensions.");
+      exit(1);
+   }
+   clearSparseVector(y);
+   for( int k = 0; k < x->count; k++ )
+   {
+      frontierEntries += rowLength(A, x->indices[k]);
+   }
+
+   if( AT == NULL || frontierEntries * PULL_FRACTION <= getNNZ(A) )
+   {
+      for( int k = 0; k < x->count; k++ )
+      {
+         int i = x->indices[k];
+
+         for( RowIterator I = rowBegin(A, i); !rowAtEnd(I); rowNext(&I) )
+         {
+            int j = rowColumn(I);
+            if( !visited[j] )
+            {
+               visited[j] = true;
+               appendSparseVector(y, j, i);
+            }
+         }
+      }
+      return;
+   }
+
+   bool* inFrontier = calloc(n + 1, sizeof(bool));
+   int* reachedBy = calloc(n + 1, sizeof(int));
+
+   for( int k = 0; k < x->count; k++ )
+   {
+      inFrontier[x->indices[k]] = true;
+   }
+   #pragma omp parallel for schedule(dynamic, 256)
+   for( int j = 1; j <= n; j++ )
+   {
+      if( visited[j] )
+      {
+         continue;
+      }
+      for( RowIterator I = rowBegin(AT, j); !rowAtEnd(I); rowNext(&I) )
+      {
+         if( inFrontier[rowColumn(I)] )
+         {
+            reachedBy[j] = rowColumn(I);
+            break;
+         }
+      }
+   }
+   for( int j = 1; j <= n; j++ )
+   {
+      if( reachedBy[j] != NIL )
+      {
+         visited[j] = true;
+         appendSparseVector(y, j, reachedBy[j]);
+      }
+   }
+
+   free(inFrontier);
+   free(reachedBy);
+}
+
+// matrixBFS()
+// Runs breadth first search from source over the arcs i -> j of the
+// entries (i, j) of A, one maskedSpmspv() per level, and sets distance[v]
+// to the number of arcs on a shortest path to v and parent[v] to the
+// vertex before v on one, or INF and NIL if v is not reached. Returns the
+// number of vertices reached. The distances match those BFS() leaves in a
+// Graph with the same arcs; the parents may differ where a vertex has
+// several at the same distance.
+// pre: 1 <= source <= getMatrixSize(A), distance and parent have room for
+// 1..n
+int matrixBFS(Matrix A, int source, int* distance, int* parent)
+{
+   if( A == NULL || distance == NULL || parent == NULL )
+   {
+      printf("Matrix Error: calling matrixBFS() on NULL reference.\n");
+      exit(1);
+   }
+   int n = A->dimensions;
+
+   if( source < 1 || source > n )
+   {
+      printf("Error: Program: Sparse, module: Matrix, precondition:"
+             " matrixBFS() called with an out of bounds source.");
+      exit(1);
+   }
+   Matrix B = A;
+   Matrix BT;
+   SparseVector frontier = newSparseVector(n);
+   SparseVector next = newSparseVector(n);
+   bool* visited = calloc(n + 1, sizeof(bool));
+   int reached = 1;
+
+   // The levels walk rows many times, which is quickest when compressed.
+   if( !A->isCompressed )
+   {
+      B = copyMatrix(A);
+      compressMatrix(B);
+   }
+   BT = transpose(B);
+   for( int v = 1; v <= n; v++ )
+   {
+      distance[v] = INF;
+      parent[v] = NIL;
+   }
+   distance[source] = 0;
+   visited[source] = true;
+   appendSparseVector(frontier, source, NIL);
+
+   for( int level = 1; frontier->count != 0; level++ )
+   {
+      SparseVector spent;
+
+      maskedSpmspv(B, BT, frontier, visited, next);
+      for( int k = 0; k < next->count; k++ )
+      {
+         distance[next->indices[k]] = level;
+         parent[next->indices[k]] = (int)next->values[k];
+      }
+      reached += next->count;
+      spent = frontier;
+      frontier = next;
+      next = spent;
+   }
+
+   if( B != A )
+   {
+      freeMatrix(&B);
+   }
+   freeMatrix(&BT);
+   freeSparseVector(&frontier);
+   freeSparseVector(&next);
+   free(visited);
+   return reached;
+}
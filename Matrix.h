@@ -3,9 +3,12 @@
 
 #include <stdbool.h>
 #include "EntryList.h"
+#include "MemoryUsage.h"
 #include<stdio.h>
 #include<stdlib.h>
 #include<string.h>
+#define INF -2
+#define NIL 0
 
 // Entry type -----------------------------------------------------------------
 
@@ -26,6 +29,10 @@ Entry newEntry(int columnNumber, double data); // changed int to object.
 // preconditions: 
 Entry copyEntry(Entry other);
 
+// freeEntry()
+// Frees an entry made by newEntry() or copyEntry(), sets *pE to NULL.
+void freeEntry(Entry* pE);
+
 // Access Functions -----------------------------------------------------------
 // getEntryColumn()
 // returns the column field in an entry struct.
@@ -51,6 +58,39 @@ void entryToString(Entry E, FILE* file);
 
 typedef struct MatrixObj* Matrix;
 
+// Semirings for semiringMult(), semiringSpmv() and semiringClosure(). Under
+// (+, x) an entry absent from a Matrix stands for 0, under (min, +) for no
+// arc, of infinite length, and under (OR, AND) for false; any stored entry
+// is true.
+#define SEMIRING_PLUS_TIMES 1
+#define SEMIRING_MIN_PLUS   2
+#define SEMIRING_OR_AND     3
+
+// Preconditioners for conjugateGradient().
+#define PRECONDITION_NONE                0
+#define PRECONDITION_JACOBI              1
+#define PRECONDITION_INCOMPLETE_CHOLESKY 2
+
+// ConjugateGradientCallback
+// Called by conjugateGradient() after every iteration with its number, the
+// 2-norm of the residual and the data pointer given to it. Returning false
+// stops the solve.
+typedef bool (*ConjugateGradientCallback)(int iteration, double residual,
+                                          void* data);
+
+// RowIterator
+// A read position in a row of a Matrix of either storage mode that leaves
+// the row untouched, so that many threads can read a Matrix at once. Its
+// fields are private.
+typedef struct RowIterator
+{
+   ListIterator entry;     // rows kept as Lists
+   const int* columns;     // compressed rows, NULL otherwise
+   const double* values;
+   int position;
+   int end;
+} RowIterator;
+
 // Contructors and destructors ------------------------------------------------
 
 // newMatrix()
@@ -64,9 +104,18 @@ Matrix newMatrix(int n);
 void freeMatrix(Matrix* pM);
 
 // copyMatrix()
-// Deep-copies a matrix.
+// Deep-copies a matrix, keeping its storage mode.
 Matrix copyMatrix(Matrix M);
 
+// buildCompressedMatrix()
+// returns a new compressed n by n Matrix holding the count entries given as
+// triples (rows[k], columns[k], values[k]) in any order. Repeated positions
+// are summed and entries that sum to zero are dropped. Takes O(n + count)
+// time plus sorting each row, and a handful of mallocs.
+// pre: 1<=rows[k]<=n, 1<=columns[k]<=n
+Matrix buildCompressedMatrix(int n, int* rows, int* columns, double* values,
+                             int count);
+
 // Access Functions -----------------------------------------------------------
 
 // getMatrixSize()
@@ -82,9 +131,55 @@ int getNNZ(Matrix M);
 bool matrixEquals(Matrix L, Matrix R);
 
 // getMatrixEntryData()
-// returns the data in an Entry when given column and row as arguments.
+// returns the data in an Entry when given column and row as arguments, or
+// 0.0 if there is none. Searches a compressed row by bisection, a row kept
+// as a List from the front, and a row in the table of hashMatrix() by
+// hashing.
 double getMatrixEntryData(Matrix M, int column, int row);
 
+// getEntries()
+// Sets out[k] to the value at row rows[k], column columns[k] of M, for
+// 0 <= k < count. The queries are sorted by row and column first, so every
+// row is walked at most once however many of them it answers.
+// pre: 1<=rows[k]<=getMatrixSize(M), 1<=columns[k]<=getMatrixSize(M)
+void getEntries(Matrix M, const int* rows, const int* columns, double* out,
+                int count);
+
+// isMatrixCompressed()
+// Returns true if M keeps its entries in compressed sparse row form.
+bool isMatrixCompressed(Matrix M);
+
+// rowBegin()
+// Returns an iterator under the first entry of row i of M. Walking a row
+// this way leaves it untouched, so many threads can read M at once.
+// Pre: 1 <= i <= getMatrixSize(M)
+RowIterator rowBegin(Matrix M, int i);
+
+// rowAtEnd()
+// Returns true if I has gone past the last entry of its row.
+bool rowAtEnd(RowIterator I);
+
+// rowColumn()
+// Returns the column of the entry under I.
+// Pre: !rowAtEnd(I)
+int rowColumn(RowIterator I);
+
+// rowData()
+// Returns the value of the entry under I.
+// Pre: !rowAtEnd(I)
+double rowData(RowIterator I);
+
+// rowNext()
+// Moves *pI to the next entry of its row.
+// Pre: !rowAtEnd(*pI)
+void rowNext(RowIterator* pI);
+
+// matrixMemoryUsage()
+// Returns the bytes held by M: the row lists and their nodes, the entries,
+// the array of rows and the matrixObj itself, or the compressed arrays, the
+// table of hashMatrix() and the transpose kept by spmvT().
+MemoryUsage matrixMemoryUsage(Matrix M);
+
 // Manipulation procedures -------------------------------------------------
 
 // makeZero()
@@ -93,10 +188,47 @@ double getMatrixEntryData(Matrix M, int column, int row);
 void makeZero(Matrix M);
 
 // changeEntry()
-// changes ith row, jth column of this Matrix to x
+// changes ith row, jth column of this Matrix to x. On a compressed Matrix
+// an entry already there is overwritten in place, or removed if x is 0;
+// only a new entry expands the Matrix back to lists, which takes several
+// times the memory of the arrays, so build big changes with
+// buildCompressedMatrix() or matrixAxpy() instead.
 // pre: 1<=i<=getMatrixSize(), 1<=j<=getMatrixSize()
 void changeEntry(Matrix M, int i, int j, double x);
 
+// compressMatrix()
+// Moves the entries of M into compressed sparse row form: one array of
+// columns and one of values, with every row stored contiguously in order.
+// Does nothing if M is already compressed.
+void compressMatrix(Matrix M);
+
+// expandMatrix()
+// Moves the entries of a compressed M back into one List per row. Does
+// nothing if M is not compressed.
+void expandMatrix(Matrix M);
+
+// hashMatrix()
+// Builds a table of the entries in the rows of M holding at least 32
+// entries, through which getMatrixEntryData() and getEntries() find them in
+// constant expected time. Any change to M drops the table.
+void hashMatrix(Matrix M);
+
+// unhashMatrix()
+// Frees the table built by hashMatrix(), if M has one.
+void unhashMatrix(Matrix M);
+
+// buildMatrix()
+// returns a new n by n Matrix holding the count entries given as triples
+// (rows[k], columns[k], values[k]) in any order. Leaves the Matrix as
+// calling changeEntry() on every triple in turn would, so the last of
+// repeated positions wins, but sorts each row once instead.
+// pre: 1<=rows[k]<=n, 1<=columns[k]<=n
+Matrix buildMatrix(int n, int* rows, int* columns, double* values,
+                   int count);
+
+// The arithmetic below returns a compressed Matrix whenever one of its
+// arguments is compressed, and works on the arrays directly.
+
 // scalarMult()
 // returns a new Matrix that is the scalar product of this Matrix with x
 Matrix scalarMult(Matrix M, double x);
@@ -111,29 +243,278 @@ Matrix add(Matrix L, Matrix R);
 // pre: getMatrixSize()==M.getMatrixSize()
 Matrix sub(Matrix L, Matrix R);
 
+// The three procedures below change their first argument in place, keeping
+// its storage mode, and never allocate a new Matrix.
+
+// matrixScaleInPlace()
+// Multiplies every entry of M by alpha without allocating. An alpha of 0
+// empties M.
+void matrixScaleInPlace(Matrix M, double alpha);
+
+// matrixAxpy()
+// Adds alpha X to Y in place, leaving out entries that cancel. Y is
+// updated without allocating when X only has entries where Y does.
+// pre: getMatrixSize(Y)==getMatrixSize(X)
+void matrixAxpy(Matrix Y, double alpha, Matrix X);
+
+// matrixHadamardInPlace()
+// Multiplies every entry of Y by the entry of X at the same place, the
+// entries of Y with none in X becoming zero, without allocating.
+// pre: getMatrixSize(Y)==getMatrixSize(X)
+void matrixHadamardInPlace(Matrix Y, Matrix X);
+
 // transpose()
-// returns a new Matrix that is the transpose of this Matrix 
-Matrix transpose();
+// returns a new Matrix that is the transpose of this Matrix, in the same
+// storage mode. Counts the entries of every column and scatters the rows in
+// order, so it takes O(n + nnz) time, and large matrices are split among
+// threads.
+Matrix transpose(Matrix M);
     
 // mult()
-// returns a new Matrix that is the product of this Matrix with M
+// returns a new Matrix that is the product of this Matrix with M. Works row
+// by row, so the time follows the products of entries that meet rather than
+// n squared, and the rows are split among threads.
 // pre: getMatrixSize()==M.getMatrixSize()
 Matrix mult(Matrix L, Matrix R);
 
+// semiringMult()
+// returns a new Matrix that is the product L R under semiring, one of the
+// SEMIRING_ constants, computed as mult() does. Only (+, x) leaves out sums
+// that come to 0.0; under (OR, AND) every entry of the product is 1.0.
+// pre: getMatrixSize(L)==getMatrixSize(R)
+Matrix semiringMult(Matrix L, Matrix R, int semiring);
+
+// semiringClosure()
+// returns the sum under semiring of M, M M, M M M, ... by repeated
+// squaring: C becomes C + C C until it stops changing, which takes about
+// log2(n) products. Under (min, +) entry (i, j) of the result is the length
+// of a shortest path of one arc or more from i to j, taking entry
+// (i, j) of M as the length of the arc from i to j, and under (OR, AND) it
+// is 1.0 if there is such a path. The result is in the same storage mode
+// as M.
+// pre: semiring is SEMIRING_MIN_PLUS, where M has no negative cycle, or
+// SEMIRING_OR_AND
+Matrix semiringClosure(Matrix M, int semiring);
+
+// permuteMatrix()
+// returns a new Matrix where row and column i of M become row and column
+// newLabel[i], in the same storage mode as M.
+// pre: newLabel[1..getMatrixSize()] is a permutation of 1..getMatrixSize()
+Matrix permuteMatrix(Matrix M, int* newLabel);
+
 // Other Functions ---------------------------------------------------------
 
 // matrixToString()
-// returns a text representation of the matrix.
+// writes a text representation of the matrix to out, one "i:(j, x) ..."
+// line per row, through a large buffer.
 void matrixToString(FILE * out, Matrix M);
 
+// writeMatrixSegments()
+// writes the lines of matrixToString() to segmentCount files named
+// pathPrefix.0, pathPrefix.1, ... in parallel, splitting the rows into
+// ranges of about the same output size. Concatenated in order, the files
+// hold exactly what matrixToString() writes. Returns false if a file could
+// not be written.
+bool writeMatrixSegments(Matrix M, const char* pathPrefix, int segmentCount);
+
 // dot()
 // Takes the dot product of two lists.
 double dot(List P, List Q);
+
+// spmv()
+// Sets y[1..n] to M x[1..n], where n is the size of M. Rows are split among
+// threads in ranges holding about the same number of entries. A Matrix
+// that is not compressed is copied into arrays on every call, so compress
+// M first to multiply it many times. x and y must not overlap.
+void spmv(Matrix M, const double* x, double* y);
+
+// spmvT()
+// Sets y[1..n] to the transpose of M times x[1..n], under the same terms
+// as spmv(). On one thread the rows of M are scattered into y. On more,
+// the first call builds the compressed transpose of M and keeps it with M
+// until M changes, so later calls run as fast as spmv().
+void spmvT(Matrix M, const double* x, double* y);
+
+// semiringSpmv()
+// Sets y[1..n] to M x[1..n] under semiring, one of the SEMIRING_
+// constants, under the same terms as spmv(). A row with no entries gives
+// the zero of the semiring: 0.0, or INFINITY under (min, +).
+void semiringSpmv(Matrix M, const double* x, double* y, int semiring);
+
+// powerIteration()
+// Runs the power method on M starting from x[1..n], where n is the size of
+// M, and leaves in x the dominant eigenvector scaled to unit length. Stops
+// once an iteration changes x by less than tolerance (in the 1-norm) or
+// after maxIterations. Stores the eigenvalue estimate in *pEigenvalue if it
+// is not NULL. Returns the number of iterations.
+int powerIteration(Matrix M, double* x, double tolerance, int maxIterations,
+                   double* pEigenvalue);
+
+// conjugateGradient()
+// Solves A x = b for the symmetric positive (semi)definite A, such as a
+// graph Laplacian, by the preconditioned conjugate gradient method,
+// starting from the guess in x[1..n] and leaving the solution there.
+// preconditioner is one of the PRECONDITION_ constants; incomplete
+// Cholesky keeps the pattern of the lower triangle of A. Stops once the
+// 2-norm of the residual b - A x is at most tolerance times that of b,
+// after maxIterations, or when callback returns false; callback may be
+// NULL. Stores that norm in *pResidual if it is not NULL. Returns the
+// number of iterations. Each iteration takes the product with A and p.Ap
+// in one threaded pass, and updates x and r with their products in
+// another; compress A first to spare a copy into arrays.
+int conjugateGradient(Matrix A, const double* b, double* x,
+                      int preconditioner, double tolerance,
+                      int maxIterations, ConjugateGradientCallback callback,
+                      void* data, double* pResidual);
    
 // Helper Functions --------------------------------------------------------
 
 // addHelper()
-// helper functions for add().
+// helper functions for add(). Returns a new List holding a + b, or a - b if
+// isSum is false.
 List addHelper(List a, List b, bool isSum);
 
+// matrixToArrays()
+// Copies the rows of M into contiguous arrays. Row i holds the entries
+// (*pColumns)[k], (*pValues)[k] for (*pRowStart)[i] <= k < (*pRowStart)[i + 1].
+// The caller frees the three arrays.
+void matrixToArrays(Matrix M, int** pRowStart, int** pColumns,
+                    double** pValues);
+
+// arraysTimesVector()
+// Sets y[1..n] to A x[1..n], where A is the n by n matrix stored in rowStart,
+// columns and values as matrixToArrays() lays it out. Rows are split among
+// threads in ranges holding about the same number of entries, so a few
+// dense rows do not leave the other threads idle.
+void arraysTimesVector(int n, int* rowStart, int* columns, double* values,
+                       const double* x, double* y);
+
+// Matrix expression type -----------------------------------------------------
+
+// Exported type --------------------------------------------------------------
+
+// MatrixExpression
+// A sum of scaled matrices such as a A + (B - C), built as a tree and
+// evaluated later in one pass, without making a Matrix for each operation.
+// Every expression passed to a constructor below is taken over by the new
+// one, so it must not be used in two expressions or freed on its own.
+typedef struct MatrixExpressionObj* MatrixExpression;
+
+// Contructors and destructors ------------------------------------------------
+
+// matrixTerm()
+// Returns an expression standing for M. M is read when the expression is
+// evaluated, not copied, so it must not be freed before then.
+MatrixExpression matrixTerm(Matrix M);
+
+// scaleExpression()
+// Returns the expression alpha E, which takes over E.
+MatrixExpression scaleExpression(double alpha, MatrixExpression E);
+
+// addExpressions()
+// Returns the expression L + R, which takes over L and R.
+// pre: L and R stand for matrices of the same size
+MatrixExpression addExpressions(MatrixExpression L, MatrixExpression R);
+
+// subExpressions()
+// Returns the expression L - R, which takes over L and R.
+// pre: L and R stand for matrices of the same size
+MatrixExpression subExpressions(MatrixExpression L, MatrixExpression R);
+
+// freeMatrixExpression()
+// Frees *pE and every expression it took over, but none of the matrices
+// they stand for, and sets *pE to NULL.
+void freeMatrixExpression(MatrixExpression* pE);
+
+// Other Functions ------------------------------------------------------------
+
+// evaluateExpression()
+// Returns a new Matrix holding the value of E, built a row at a time by
+// one merge of the rows of every Matrix in E, so no intermediate Matrix is
+// made and the memory used beyond the result does not grow with the
+// matrices. The result is compressed if one of those matrices is. E is
+// unchanged.
+Matrix evaluateExpression(MatrixExpression E);
+
+// Sparse vector type ---------------------------------------------------------
+
+// Exported type --------------------------------------------------------------
+
+// SparseVector
+// A vector of dimension n that stores only its entries, as (index, value)
+// pairs in the order they were stored. Indices go from 1 to n.
+typedef struct SparseVectorObj* SparseVector;
+
+// Contructors and destructors ------------------------------------------------
+
+// newSparseVector()
+// Returns an empty sparse vector of dimension n.
+// Precondition n >= 1.
+SparseVector newSparseVector(int n);
+
+// freeSparseVector()
+// Frees *pV and sets *pV to NULL.
+void freeSparseVector(SparseVector* pV);
+
+// Access Functions -----------------------------------------------------------
+
+// getSparseVectorSize()
+// Returns the dimension of V.
+int getSparseVectorSize(SparseVector V);
+
+// getSparseVectorNNZ()
+// Returns the number of entries stored in V.
+int getSparseVectorNNZ(SparseVector V);
+
+// sparseVectorIndex()
+// Returns the index of the kth entry of V, counting from 0 in the order
+// the entries were stored.
+// Pre: 0 <= k < getSparseVectorNNZ(V)
+int sparseVectorIndex(SparseVector V, int k);
+
+// sparseVectorValue()
+// Returns the value of the kth entry of V.
+// Pre: 0 <= k < getSparseVectorNNZ(V)
+double sparseVectorValue(SparseVector V, int k);
+
+// Manipulation procedures ----------------------------------------------------
+
+// clearSparseVector()
+// Removes every entry of V, keeping its storage.
+void clearSparseVector(SparseVector V);
+
+// appendSparseVector()
+// Stores the entry (index, value) after the entries of V. Does not look
+// for an earlier entry at index.
+// Pre: 1 <= index <= getSparseVectorSize(V)
+void appendSparseVector(SparseVector V, int index, double value);
+
+// Other Functions ------------------------------------------------------------
+
+// maskedSpmspv()
+// Sets y to the product of the transpose of A with x over the Boolean
+// semiring, masked by the complement of visited: j is put in y if it is
+// not visited and A has an entry (i, j) for some i in x, and is then
+// marked visited. The value stored for j is such an i. A sparse frontier
+// pushes through the rows of A picked by x, in the order of x, so i is the
+// first of them to reach j. When the rows of x hold more than 1/14 of the
+// entries of A and AT, the transpose of A, is not NULL, every unvisited j
+// pulls instead through row j of AT, stopping at the first i in x, which
+// is then the smallest; y is then in increasing order.
+// pre: A, AT, x and y have the same size, visited has room for 1..n
+void maskedSpmspv(Matrix A, Matrix AT, SparseVector x, bool* visited,
+                  SparseVector y);
+
+// matrixBFS()
+// Runs breadth first search from source over the arcs i -> j of the
+// entries (i, j) of A, one maskedSpmspv() per level, and sets distance[v]
+// to the number of arcs on a shortest path to v and parent[v] to the
+// vertex before v on one, or INF and NIL if v is not reached. Returns the
+// number of vertices reached. The distances match those BFS() leaves in a
+// Graph with the same arcs; the parents may differ where a vertex has
+// several at the same distance.
+// pre: 1 <= source <= getMatrixSize(A), distance and parent have room for
+// 1..n
+int matrixBFS(Matrix A, int source, int* distance, int* parent);
+
 #endif
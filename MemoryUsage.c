@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------
+// MemoryUsage.c
+// Implementation file for memory accounting.
+//-----------------------------------------------------------------------------
+
+#include<stdio.h>
+#include<stdlib.h>
+#include "MemoryUsage.h"
+
+// The counters are shared by every thread; they are only touched through
+// OpenMP atomics. Without OpenMP the program has a single thread anyway.
+static size_t allocatedBytes = 0;
+static size_t peakBytes = 0;
+static long long liveAllocations = 0;
+
+// Access functions -----------------------------------------------------------
+
+// newMemoryUsage()
+// Returns a MemoryUsage with every count at zero.
+MemoryUsage newMemoryUsage(void)
+{
+   MemoryUsage U = { 0, 0, 0, 0, 0 };
+   return U;
+}
+
+// totalMemoryUsage()
+// Returns the sum of the byte counts of U.
+size_t totalMemoryUsage(MemoryUsage U)
+{
+   return U.nodeBytes + U.entryBytes + U.indexBytes + U.traversalBytes;
+}
+
+// getAllocatedBytes()
+// Returns the bytes the modules have allocated and not yet freed.
+size_t getAllocatedBytes(void)
+{
+   size_t bytes;
+   #pragma omp atomic read
+   bytes = allocatedBytes;
+   return bytes;
+}
+
+// getPeakAllocatedBytes()
+// Returns the largest value getAllocatedBytes() has had.
+size_t getPeakAllocatedBytes(void)
+{
+   size_t bytes;
+   #pragma omp atomic read
+   bytes = peakBytes;
+   return bytes;
+}
+
+// getLiveAllocations()
+// Returns the number of blocks the modules have allocated and not yet freed.
+long long getLiveAllocations(void)
+{
+   long long count;
+   #pragma omp atomic read
+   count = liveAllocations;
+   return count;
+}
+
+// Manipulation procedures ----------------------------------------------------
+
+// addMemoryUsage()
+// Adds every count of U to *pTotal.
+void addMemoryUsage(MemoryUsage* pTotal, MemoryUsage U)
+{
+   if( pTotal == NULL )
+   {
+      printf("MemoryUsage Error: calling addMemoryUsage() on NULL"
+             " MemoryUsage reference.\n");
+      exit(1);
+   }
+   pTotal->nodeBytes += U.nodeBytes;
+   pTotal->entryBytes += U.entryBytes;
+   pTotal->indexBytes += U.indexBytes;
+   pTotal->traversalBytes += U.traversalBytes;
+   pTotal->allocations += U.allocations;
+}
+
+// countAllocation()
+// Records that a block of bytes bytes was allocated. Safe to call from
+// several threads.
+void countAllocation(size_t bytes)
+{
+   size_t now;
+   size_t peak;
+
+   #pragma omp atomic capture
+   now = allocatedBytes += bytes;
+   #pragma omp atomic
+   liveAllocations++;
+
+   #pragma omp atomic read
+   peak = peakBytes;
+   if( now > peak )
+   {
+      #pragma omp critical(peakBytes)
+      if( now > peakBytes )
+      {
+         peakBytes = now;
+      }
+   }
+}
+
+// countRelease()
+// Records that a block of bytes bytes was freed. Safe to call from several
+// threads.
+void countRelease(size_t bytes)
+{
+   #pragma omp atomic
+   allocatedBytes -= bytes;
+   #pragma omp atomic
+   liveAllocations--;
+}
+
+// printMemoryUsage()
+// Prints U to out, one category per line, under the given title.
+void printMemoryUsage(FILE* out, const char* title, MemoryUsage U)
+{
+   fprintf(out, "%s: %zu bytes in %zu blocks\n", title, totalMemoryUsage(U),
+           U.allocations);
+   fprintf(out, "   nodes:     %zu\n", U.nodeBytes);
+   fprintf(out, "   entries:   %zu\n", U.entryBytes);
+   fprintf(out, "   index:     %zu\n", U.indexBytes);
+   fprintf(out, "   traversal: %zu\n", U.traversalBytes);
+}
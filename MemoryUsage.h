@@ -0,0 +1,72 @@
+//-----------------------------------------------------------------------------
+// MemoryUsage.h
+// Header file for memory accounting. The Graph, Matrix, Heap, IntList and
+// List modules report what one object holds through a MemoryUsage, and keep
+// a process wide count of the bytes they have allocated and not yet freed.
+//
+// Byte counts are what the modules ask malloc() for. malloc() itself adds a
+// few bytes to every block, which the allocations field lets callers
+// estimate for their platform.
+//-----------------------------------------------------------------------------
+
+#ifndef _MEMORY_USAGE_H_INCLUDE_
+#define _MEMORY_USAGE_H_INCLUDE_
+#include<stddef.h>
+#include<stdio.h>
+
+// Exported type --------------------------------------------------------------
+
+// MemoryUsage
+// The bytes held by one object, by category.
+typedef struct MemoryUsage
+{
+   size_t nodeBytes;        // list node structs
+   size_t entryBytes;       // Matrix entry structs
+   size_t indexBytes;       // object structs and arrays indexed by position
+   size_t traversalBytes;   // per vertex state left by BFS and Dijkstra
+   size_t allocations;      // number of malloc() blocks holding the above
+} MemoryUsage;
+
+// Access functions -----------------------------------------------------------
+
+// newMemoryUsage()
+// Returns a MemoryUsage with every count at zero.
+MemoryUsage newMemoryUsage(void);
+
+// totalMemoryUsage()
+// Returns the sum of the byte counts of U.
+size_t totalMemoryUsage(MemoryUsage U);
+
+// getAllocatedBytes()
+// Returns the bytes the modules have allocated and not yet freed.
+size_t getAllocatedBytes(void);
+
+// getPeakAllocatedBytes()
+// Returns the largest value getAllocatedBytes() has had.
+size_t getPeakAllocatedBytes(void);
+
+// getLiveAllocations()
+// Returns the number of blocks the modules have allocated and not yet freed.
+long long getLiveAllocations(void);
+
+// Manipulation procedures ----------------------------------------------------
+
+// addMemoryUsage()
+// Adds every count of U to *pTotal.
+void addMemoryUsage(MemoryUsage* pTotal, MemoryUsage U);
+
+// countAllocation()
+// Records that a block of bytes bytes was allocated. Safe to call from
+// several threads.
+void countAllocation(size_t bytes);
+
+// countRelease()
+// Records that a block of bytes bytes was freed. Safe to call from several
+// threads.
+void countRelease(size_t bytes);
+
+// printMemoryUsage()
+// Prints U to out, one category per line, under the given title.
+void printMemoryUsage(FILE* out, const char* title, MemoryUsage U);
+
+#endif